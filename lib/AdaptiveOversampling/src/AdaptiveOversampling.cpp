@@ -0,0 +1,87 @@
+/*
+@file   AdaptiveOversampling.cpp
+@brief  Steps the BME280 oversampling of each channel to hold a target noise
+*/
+
+#include "AdaptiveOversampling.h"
+
+AdaptiveOversampling::AdaptiveOversampling(BME280 &bme) : _bme(bme) {
+  for (uint8_t i = 0; i < CH_COUNT; i++) {
+    _ch[i].sampling = BME280::SAMPLING_X1;
+    _ch[i].last = 0;
+    _ch[i].variance = 0;
+    _ch[i].settle = OVERSAMPLING_SETTLE_SAMPLES;
+    _ch[i].primed = false;
+  }
+  setTargetNoise(CH_TEMPERATURE, OVERSAMPLING_TARGET_TEMPERATURE);
+  setTargetNoise(CH_PRESSURE, OVERSAMPLING_TARGET_PRESSURE);
+  setTargetNoise(CH_HUMIDITY, OVERSAMPLING_TARGET_HUMIDITY);
+}
+
+void AdaptiveOversampling::setTargetNoise(Channel ch, uint32_t stddev) {
+  _ch[ch].target = stddev * stddev;
+}
+
+/*
+  The difference of two consecutive samples carries twice the noise variance,
+  slow changes of the environment only add a small term to it. Doubling the
+  oversampling halves the variance, so a channel steps up when it is above
+  its target and steps down when twice its variance still leaves margin.
+*/
+bool AdaptiveOversampling::step(State &st, int32_t value) {
+  if (!st.primed) {
+    st.last = value;
+    st.primed = true;
+    return false;
+  }
+  int32_t d = value - st.last;
+  st.last = value;
+  uint32_t sq = (d > 46340 || d < -46340) ? 0xFFFFFFFFUL : (uint32_t)(d * d);
+  // alpha = 1/8
+  st.variance = st.variance - (st.variance >> 3) + (sq >> 3);
+
+  if (st.settle > 0) {
+    st.settle--;
+    return false;
+  }
+
+  // variance holds 2 x sigma^2
+  uint32_t noise = st.variance >> 1;
+  if ((noise > st.target) && (st.sampling < BME280::SAMPLING_X16)) {
+    st.sampling = (BME280::Sampling)(st.sampling + 1);
+    st.variance >>= 1;
+  } else if ((noise < (st.target >> 2)) &&
+             (st.sampling > BME280::SAMPLING_X1)) {
+    st.sampling = (BME280::Sampling)(st.sampling - 1);
+    st.variance <<= 1;
+  } else {
+    return false;
+  }
+  st.settle = OVERSAMPLING_SETTLE_SAMPLES;
+  return true;
+}
+
+bool AdaptiveOversampling::update(int32_t temperature, int32_t pressure,
+                                  int32_t humidity) {
+  bool changed = step(_ch[CH_TEMPERATURE], temperature);
+  changed |= step(_ch[CH_PRESSURE], pressure);
+  changed |= step(_ch[CH_HUMIDITY], humidity);
+  if (changed) {
+    _bme.setOversampling(_ch[CH_TEMPERATURE].sampling,
+                         _ch[CH_PRESSURE].sampling,
+                         _ch[CH_HUMIDITY].sampling);
+  }
+  return changed;
+}
+
+uint32_t AdaptiveOversampling::getMeasurementTime_us() {
+  return BME280::getMeasurementTime_us(_ch[CH_TEMPERATURE].sampling,
+                                       _ch[CH_PRESSURE].sampling,
+                                       _ch[CH_HUMIDITY].sampling);
+}
+
+uint32_t AdaptiveOversampling::getCharge_nC() {
+  return BME280::getMeasurementCharge_nC(_ch[CH_TEMPERATURE].sampling,
+                                         _ch[CH_PRESSURE].sampling,
+                                         _ch[CH_HUMIDITY].sampling);
+}
@@ -0,0 +1,62 @@
+/*
+@file   AdaptiveOversampling.h
+@brief  Steps the BME280 oversampling of each channel up or down to hold a
+        target noise level, instead of sizing it for the worst case
+*/
+
+#ifndef _ADAPTIVE_OVERSAMPLING_H_
+#define _ADAPTIVE_OVERSAMPLING_H_
+
+#include <Arduino.h>
+#include "BME280.h"
+
+// default noise targets (standard deviation) in the units given to update()
+#ifndef OVERSAMPLING_TARGET_TEMPERATURE
+#define OVERSAMPLING_TARGET_TEMPERATURE 5 // 0.05 degC
+#endif
+#ifndef OVERSAMPLING_TARGET_PRESSURE
+#define OVERSAMPLING_TARGET_PRESSURE 5 // Pa
+#endif
+#ifndef OVERSAMPLING_TARGET_HUMIDITY
+#define OVERSAMPLING_TARGET_HUMIDITY 20 // 0.20 %RH
+#endif
+
+// samples to wait after a change before the channel is evaluated again
+#ifndef OVERSAMPLING_SETTLE_SAMPLES
+#define OVERSAMPLING_SETTLE_SAMPLES 8
+#endif
+
+class AdaptiveOversampling {
+
+public:
+  enum Channel : uint8_t { CH_TEMPERATURE, CH_PRESSURE, CH_HUMIDITY, CH_COUNT };
+
+  AdaptiveOversampling(BME280 &bme);
+
+  void setTargetNoise(Channel ch, uint32_t stddev);
+  // feed one sample: temperature in 0.01 degC, pressure in Pa, humidity in
+  // 0.01 %RH. Returns true when the oversampling was changed.
+  bool update(int32_t temperature, int32_t pressure, int32_t humidity);
+
+  BME280::Sampling getSampling(Channel ch) { return _ch[ch].sampling; }
+  uint32_t getVariance(Channel ch) { return _ch[ch].variance >> 1; }
+  uint32_t getMeasurementTime_us();
+  uint32_t getCharge_nC();
+
+private:
+  struct State {
+    BME280::Sampling sampling;
+    int32_t last;
+    uint32_t variance; // EWMA of the squared sample-to-sample difference
+    uint32_t target;   // target variance
+    uint8_t settle;    // samples until the next decision
+    bool primed;
+  };
+
+  BME280 &_bme;
+  State _ch[CH_COUNT];
+
+  bool step(State &st, int32_t value);
+};
+
+#endif // _ADAPTIVE_OVERSAMPLING_H_
@@ -21,6 +21,9 @@
 
 #include "Arduino.h"
 #include "BME280.h"
+#ifdef USE_BUS_TRACE
+#include "BusTrace.h"
+#endif
 
 /* BME280 object, input the I2C bus and address */
 BME280::BME280(TwoWire &bus,uint8_t address){
@@ -88,6 +91,84 @@ int BME280::begin() {
   return 1;
 }
 
+/* starts communication with trimming parameters read by an earlier begin(),
+   skipping the soft reset and the trimming read */
+int BME280::beginWithTrimming(const Trimming &trimming) {
+  if( _useSPI ){ // using SPI for communication
+    pinMode(_csPin,OUTPUT);
+    // a falling edge of CS locks the BME280 in SPI mode
+    digitalWrite(_csPin,LOW);
+    digitalWrite(_csPin,HIGH);
+    _spi->begin();
+  }
+  else{ // using I2C for communication
+    _i2c->begin();
+    _i2c->setClock(_i2cRate);
+  }
+  // check the who am i register
+  if (readRegisters(WHO_AM_I_REG,1,_buffer) < 0) {
+    return -1;
+  } else {
+    if(_buffer[0]!=0x60) {
+      return -2;
+    }
+  }
+  // the sensor may have been power cycled together with the MCU
+  readRegisters(STATUS_REG,1,_buffer);
+  while((_buffer[0] & 0x01)!=0) {
+    readRegisters(STATUS_REG,1,_buffer);
+  }
+  _dig_T1 = trimming.T1;
+  _dig_T2 = trimming.T2;
+  _dig_T3 = trimming.T3;
+  _dig_P1 = trimming.P1;
+  _dig_P2 = trimming.P2;
+  _dig_P3 = trimming.P3;
+  _dig_P4 = trimming.P4;
+  _dig_P5 = trimming.P5;
+  _dig_P6 = trimming.P6;
+  _dig_P7 = trimming.P7;
+  _dig_P8 = trimming.P8;
+  _dig_P9 = trimming.P9;
+  _dig_H1 = trimming.H1;
+  _dig_H2 = trimming.H2;
+  _dig_H3 = trimming.H3;
+  _dig_H4 = trimming.H4;
+  _dig_H5 = trimming.H5;
+  _dig_H6 = trimming.H6;
+  // setup sensor without the delayed read back of every register
+  _verifyWrites = false;
+  _status = configureBME280();
+  _verifyWrites = true;
+  if(_status < 0) {
+    return(-4 + _status);
+  }
+  // successful init, return 1
+  return 1;
+}
+
+/* copies the trimming parameters read by begin() */
+void BME280::getTrimming(Trimming *trimming) {
+  trimming->T1 = _dig_T1;
+  trimming->T2 = _dig_T2;
+  trimming->T3 = _dig_T3;
+  trimming->P1 = _dig_P1;
+  trimming->P2 = _dig_P2;
+  trimming->P3 = _dig_P3;
+  trimming->P4 = _dig_P4;
+  trimming->P5 = _dig_P5;
+  trimming->P6 = _dig_P6;
+  trimming->P7 = _dig_P7;
+  trimming->P8 = _dig_P8;
+  trimming->P9 = _dig_P9;
+  trimming->H1 = _dig_H1;
+  trimming->H2 = _dig_H2;
+  trimming->H3 = _dig_H3;
+  trimming->H4 = _dig_H4;
+  trimming->H5 = _dig_H5;
+  trimming->H6 = _dig_H6;
+}
+
 /* sets the pressure oversampling */
 int BME280::setPressureOversampling(Sampling pressureSampling) {
   _Psampling = pressureSampling;
@@ -121,6 +202,75 @@ int BME280::setHumidityOversampling(Sampling humiditySampling) {
   return 1;
 }
 
+/* sets the temperature, pressure and humidity oversampling at once */
+int BME280::setOversampling(Sampling temperatureSampling, Sampling pressureSampling, Sampling humiditySampling) {
+  bool humidityChanged = (humiditySampling != _Hsampling);
+  _Tsampling = temperatureSampling;
+  _Psampling = pressureSampling;
+  _Hsampling = humiditySampling;
+  if (_mode == MODE_FORCED) {
+    // temperature and pressure go out with the next forced trigger, which is
+    // also the ctrl_meas write that makes a new ctrl_hum value effective
+    if (humidityChanged && (writeRegister(CTRL_HUM_REG,_Hsampling) < 0)) {
+      return -1;
+    }
+    return 1;
+  }
+  // setup sensor
+  if(configureBME280() < 0) {
+    return -1;
+  }
+  // success, return 1
+  return 1;
+}
+
+/* returns the maximum measurement time in us for the given oversampling, see
+   datasheet section 9.1 */
+uint32_t BME280::getMeasurementTime_us(Sampling temperatureSampling, Sampling pressureSampling, Sampling humiditySampling) {
+  uint32_t t_os = 1UL << (temperatureSampling - 1);
+  uint32_t p_os = 1UL << (pressureSampling - 1);
+  uint32_t h_os = 1UL << (humiditySampling - 1);
+  return 1250 + 2300 * t_os + (2300 * p_os + 575) + (2300 * h_os + 575);
+}
+
+/* returns the maximum measurement time in us for the current oversampling */
+uint32_t BME280::getMeasurementTime_us() {
+  return getMeasurementTime_us(_Tsampling, _Psampling, _Hsampling);
+}
+
+/* returns the charge in nC of one measurement for the given oversampling,
+   using the phases of the maximum measurement time and the supply current
+   of each phase from datasheet table 1 (us x uA = pC) */
+uint32_t BME280::getMeasurementCharge_nC(Sampling temperatureSampling, Sampling pressureSampling, Sampling humiditySampling) {
+  uint32_t t_os = 1UL << (temperatureSampling - 1);
+  uint32_t p_os = 1UL << (pressureSampling - 1);
+  uint32_t h_os = 1UL << (humiditySampling - 1);
+  uint32_t pC = (1250 + 2300 * t_os) * 350 +
+                (2300 * p_os + 575) * 714 +
+                (2300 * h_os + 575) * 340;
+  return pC / 1000;
+}
+
+/* returns the charge in nC of one measurement for the current oversampling */
+uint32_t BME280::getMeasurementCharge_nC() {
+  return getMeasurementCharge_nC(_Tsampling, _Psampling, _Hsampling);
+}
+
+/* returns the normal mode standby time in us */
+uint32_t BME280::getStandbyTime_us(Standby standbyTime) {
+  switch (standbyTime) {
+    case STANDBY_0_5_MS: return 500;
+    case STANDBY_62_5_MS: return 62500;
+    case STANDBY_125_MS: return 125000;
+    case STANDBY_250_MS: return 250000;
+    case STANDBY_500_MS: return 500000;
+    case STANDBY_1000_MS: return 1000000;
+    case STANDBY_10_MS: return 10000;
+    case STANDBY_20_MS: return 20000;
+  }
+  return 0;
+}
+
 /* sets the IIR filter coefficient */
 int BME280::setIirCoefficient(Iirc iirCoefficient) {
   _iirc = iirCoefficient;
@@ -181,9 +331,9 @@ int BME280::readSensor() {
     if (getDataCounts(&_pressureCounts, &_temperatureCounts, &_humidityCounts) < 0) {
       return -1;
     } else {
-      compensateTemperature(_temperatureCounts,&_t_fine,&_data.Temp_C);
-      compensatePressure(_pressureCounts,_t_fine,&_data.Pressure_Pa);
-      compensateHumidity(_humidityCounts,_t_fine,&_data.Humidity_RH);
+      compensateTemperature(_temperatureCounts,&_t_fine,&_data.Temp_cC);
+      compensatePressure(_pressureCounts,_t_fine,&_data.Pressure_Pa_Q8);
+      compensateHumidity(_humidityCounts,_t_fine,&_data.Humidity_RH_Q10);
       return 1;
     }
   }
@@ -196,6 +346,9 @@ int BME280::readSensor() {
       _spi->transfer(((_Tsampling << 5) | (_Psampling << 3) | _mode )); // write the data
       digitalWrite(_csPin,HIGH); // deselect the BME280 chip
       _spi->endTransaction(); // end the transaction
+#ifdef USE_BUS_TRACE
+      BusTracer.record(_csPin, CTRL_MEAS_REG, BusTrace::BUS_WRITE, 1, SPI_CLOCK);
+#endif
     }
     else{
       _i2c->beginTransmission(_address); // open the device
@@ -217,41 +370,41 @@ int BME280::readSensor() {
     if (getDataCounts(&_pressureCounts, &_temperatureCounts, &_humidityCounts) < 0) {
       return -1;
     } else {
-      compensateTemperature(_temperatureCounts,&_t_fine,&_data.Temp_C);
-      compensatePressure(_pressureCounts,_t_fine,&_data.Pressure_Pa);
-      compensateHumidity(_humidityCounts,_t_fine,&_data.Humidity_RH);
+      compensateTemperature(_temperatureCounts,&_t_fine,&_data.Temp_cC);
+      compensatePressure(_pressureCounts,_t_fine,&_data.Pressure_Pa_Q8);
+      compensateHumidity(_humidityCounts,_t_fine,&_data.Humidity_RH_Q10);
       return 1;
     }
   }
 }
 
-/* returns the pressure value, PA */
-float BME280::getPressure_Pa(){
-  return _data.Pressure_Pa;
+/* returns the pressure value, Pa in 24.8 fixed point */
+uint32_t BME280::getPressure_Pa_Q8(){
+  return _data.Pressure_Pa_Q8;
 }
 
-/* returns the temperature value, C */
-float BME280::getTemperature_C(){
-  return _data.Temp_C;
+/* returns the temperature value, 0.01 C */
+int32_t BME280::getTemperature_cC(){
+  return _data.Temp_cC;
 }
 
-/* returns the humidity value, RH */
-float BME280::getHumidity_RH(){
-  return _data.Humidity_RH;
+/* returns the humidity value, 0.01 %RH */
+uint32_t BME280::getHumidity_cRH(){
+  return (_data.Humidity_RH_Q10*100+512)>>10;
 }
 
 /* compensates the temperature measurement from the BME280 */
-void BME280::compensateTemperature(int32_t temperatureCounts, int32_t* t_fine, float* temperature) {
+void BME280::compensateTemperature(int32_t temperatureCounts, int32_t* t_fine, int32_t* temperature) {
   _tvar1=((((temperatureCounts>>3)-((int32_t)_dig_T1<<1)))*((int32_t)_dig_T2))>>11;
   _tvar2=(((((temperatureCounts>>4)-((int32_t)_dig_T1))*((temperatureCounts>>4)-((int32_t)_dig_T1)))>>12)
     *((int32_t)_dig_T3))>>14;
   *t_fine=_tvar1+_tvar2;
   _T=(*t_fine*5+128)>>8;
-  *temperature = ((float)_T)/100.0f;
+  *temperature = _T;
 }
 
 /* compensates the pressure measurement from the BME280 */
-void BME280::compensatePressure(int32_t pressureCounts, int32_t t_fine, float* pressure) {
+void BME280::compensatePressure(int32_t pressureCounts, int32_t t_fine, uint32_t* pressure) {
   _pvar1=((int64_t)t_fine)-128000;
   _pvar2=_pvar1*_pvar1*(int64_t)_dig_P6;
   _pvar2=_pvar2+((_pvar1*(int64_t)_dig_P5)<<17);
@@ -259,19 +412,19 @@ void BME280::compensatePressure(int32_t pressureCounts, int32_t t_fine, float* p
   _pvar1=((_pvar1*_pvar1*(int64_t)_dig_P3)>>8)+((_pvar1*(int64_t)_dig_P2)<<12);
   _pvar1=(((((int64_t)1)<<47)+_pvar1))*((int64_t)_dig_P1)>>33;
   if(_pvar1==0) {
-    *pressure = 0.0f;
+    *pressure = 0;
   } else {
     _p=1048576-pressureCounts;
     _p=(((_p<<31)-_pvar2)*3125)/_pvar1;
     _pvar1=(((int64_t)_dig_P9)*(_p>>13)*(_p>>13))>>25;
     _pvar2=(((int64_t)_dig_P8)*_p)>>19;
     _p=((_p+_pvar1+_pvar2)>>8)+(((int64_t)_dig_P7)<<4);
-    *pressure=(float)((uint32_t)_p)/256.0f;
+    *pressure=(uint32_t)_p;
   }
 }
 
 /* compensates the humidity measurement from the BME280 */
-void BME280::compensateHumidity(int32_t humidityCounts, int32_t t_fine, float* humidity) {
+void BME280::compensateHumidity(int32_t humidityCounts, int32_t t_fine, uint32_t* humidity) {
   _hv_x1_u32r=(t_fine-((int32_t)76800));
   _hv_x1_u32r=(((((humidityCounts<<14)-(((int32_t)_dig_H4)<<20)-(((int32_t)_dig_H5)*_hv_x1_u32r))+
     ((int32_t)16384))>>15)*(((((((_hv_x1_u32r*((int32_t)_dig_H6))>>10)*
@@ -280,7 +433,7 @@ void BME280::compensateHumidity(int32_t humidityCounts, int32_t t_fine, float* h
   _hv_x1_u32r=(_hv_x1_u32r-(((((_hv_x1_u32r>>15)*(_hv_x1_u32r>>15))>>7)*((int32_t)_dig_H1))>>4));
   _hv_x1_u32r=(_hv_x1_u32r < 0 ? 0 : _hv_x1_u32r);
   _hv_x1_u32r=(_hv_x1_u32r > 419430400 ? 419430400 : _hv_x1_u32r);
-  *humidity=(float)((uint32_t)(_hv_x1_u32r>>12))/1024.0f;
+  *humidity=(uint32_t)(_hv_x1_u32r>>12);
 }
 
 /* returns counts for temperature, pressure, and humidity */
@@ -422,6 +575,9 @@ int BME280::writeRegister(uint8_t subAddress, uint8_t data){
     _spi->transfer(data); // write the data
     digitalWrite(_csPin,HIGH); // deselect the BME280 chip
     _spi->endTransaction(); // end the transaction
+#ifdef USE_BUS_TRACE
+    BusTracer.record(_csPin, subAddress, BusTrace::BUS_WRITE, 1, SPI_CLOCK);
+#endif
   }
   else{
     _i2c->beginTransmission(_address); // open the device
@@ -430,6 +586,10 @@ int BME280::writeRegister(uint8_t subAddress, uint8_t data){
     _i2c->endTransmission();
   }
 
+  if (!_verifyWrites) {
+    return 1;
+  }
+
   delay(10);
 
   /* read back the register */
@@ -456,6 +616,9 @@ int BME280::readRegisters(uint8_t subAddress, uint8_t count, uint8_t* dest){
     }
     digitalWrite(_csPin,HIGH); // deselect the BME280 chip
     _spi->endTransaction(); // end the transaction
+#ifdef USE_BUS_TRACE
+    BusTracer.record(_csPin, subAddress, BusTrace::BUS_READ, count, SPI_CLOCK);
+#endif
     return 1;
   }
   else{
@@ -61,12 +61,37 @@ class BME280{
       MODE_FORCED = 0x01,
       MODE_NORMAL = 0x03
     };
+    // trimming parameters, kept to skip reading them after a warm reset
+    struct Trimming {
+      uint16_t T1;
+      int16_t T2, T3;
+      uint16_t P1;
+      int16_t P2, P3, P4, P5, P6, P7, P8, P9;
+      uint8_t H1, H3;
+      int16_t H2, H4, H5;
+      int8_t H6;
+    };
     BME280(TwoWire &bus,uint8_t address);
     BME280(SPIClass &bus,uint8_t csPin);
     int begin();
+    // added beginWithTrimming() and getTrimming() for the warm boot
+    int beginWithTrimming(const Trimming &trimming);
+    void getTrimming(Trimming *trimming);
     int setPressureOversampling(Sampling pressureSampling);
     int setTemperatureOversampling(Sampling temperatureSampling);
     int setHumidityOversampling(Sampling humiditySampling);
+    // added setOversampling() and the measurement time helpers
+    int setOversampling(Sampling temperatureSampling, Sampling pressureSampling, Sampling humiditySampling);
+    Sampling getTemperatureOversampling() { return _Tsampling; }
+    Sampling getPressureOversampling() { return _Psampling; }
+    Sampling getHumidityOversampling() { return _Hsampling; }
+    static uint32_t getMeasurementTime_us(Sampling temperatureSampling, Sampling pressureSampling, Sampling humiditySampling);
+    uint32_t getMeasurementTime_us();
+    static uint32_t getMeasurementCharge_nC(Sampling temperatureSampling, Sampling pressureSampling, Sampling humiditySampling);
+    uint32_t getMeasurementCharge_nC();
+    static uint32_t getStandbyTime_us(Standby standbyTime);
+    Standby getStandbyTime() { return _standby; }
+    Mode getMode() { return _mode; }
     int setIirCoefficient(Iirc iirCoefficient);
     int setStandbyTime(Standby standbyTime);
     int setNormalMode();
@@ -74,15 +99,20 @@ class BME280{
     // added goToSleep()
     int goToSleep();
     int readSensor();
-    float getPressure_Pa();
-    float getTemperature_C();
-    float getHumidity_RH();
+    // float results, inline so only the callers link the float code
+    float getPressure_Pa() { return (float)_data.Pressure_Pa_Q8 / 256.0f; }
+    float getTemperature_C() { return (float)_data.Temp_cC / 100.0f; }
+    float getHumidity_RH() { return (float)_data.Humidity_RH_Q10 / 1024.0f; }
+    // fixed point results
+    uint32_t getPressure_Pa_Q8();    // Pa * 256
+    int32_t getTemperature_cC();     // 0.01 degC
+    uint32_t getHumidity_cRH();      // 0.01 %RH
   private:
     // struct to hold sensor data
     struct Data {
-      float Pressure_Pa;
-      float Temp_C;
-      float Humidity_RH;
+      uint32_t Pressure_Pa_Q8;
+      int32_t Temp_cC;
+      uint32_t Humidity_RH_Q10;
     };
     Data _data;
     // temperature output, int32
@@ -126,6 +156,8 @@ class BME280{
     Iirc _iirc = IIRC_OFF;
     Standby _standby = STANDBY_0_5_MS;
     Mode _mode = MODE_NORMAL;
+    // read back every register write, skipped during a warm boot
+    bool _verifyWrites = true;
     // SPI 3 wire interface
     const uint8_t _spi3w_en = 0x00;
     // BME280 registers
@@ -155,9 +187,9 @@ class BME280{
     const uint8_t DIG_H4_REG = 0xE4;
     const uint8_t DIG_H5_REG = 0xE5;
     const uint8_t DIG_H6_REG = 0xE7;
-    void compensateTemperature(int32_t temperatureCounts, int32_t* t_fine, float* temperature);
-    void compensatePressure(int32_t pressureCounts, int32_t t_fine, float* pressure);
-    void compensateHumidity(int32_t humidityCounts, int32_t t_fine, float* humidity);
+    void compensateTemperature(int32_t temperatureCounts, int32_t* t_fine, int32_t* temperature);
+    void compensatePressure(int32_t pressureCounts, int32_t t_fine, uint32_t* pressure);
+    void compensateHumidity(int32_t humidityCounts, int32_t t_fine, uint32_t* humidity);
     int getDataCounts(int32_t* pressureCounts, int32_t* temperatureCounts, int32_t* humidityCounts);
     int configureBME280();
     int readTrimmingParameters();
@@ -0,0 +1,89 @@
+/*
+@file   BME280Stream.cpp
+@brief  Normal mode streaming with MCU side decimation
+*/
+
+#include "BME280Stream.h"
+
+BME280Stream::BME280Stream(BME280 &bme) : _bme(bme) {
+  _decimation = BME280_STREAM_DECIMATION;
+  _count = 0;
+  _sumTemperature = 0;
+  _sumPressure = 0;
+  _sumHumidity = 0;
+}
+
+// call after BME280::begin(), leaves the sensor free running
+int BME280Stream::begin(BME280::Standby standby, BME280::Iirc iirc,
+                        uint8_t decimation) {
+  _decimation = (decimation == 0) ? 1 : decimation;
+  _count = 0;
+  _sumTemperature = 0;
+  _sumPressure = 0;
+  _sumHumidity = 0;
+  if (_bme.setStandbyTime(standby) < 0) {
+    return -1;
+  }
+  if (_bme.setIirCoefficient(iirc) < 0) {
+    return -2;
+  }
+  if (_bme.setNormalMode() < 0) {
+    return -3;
+  }
+  return 1;
+}
+
+// read the latest data burst and add it to the aggregator
+int BME280Stream::poll() {
+  if (_bme.readSensor() < 0) {
+    return -1;
+  }
+  _sumTemperature += _bme.getTemperature_cC();
+  _sumPressure += (int32_t)(_bme.getPressure_Pa_Q8() >> 8);
+  _sumHumidity += (int32_t)_bme.getHumidity_cRH();
+  _count++;
+  return 1;
+}
+
+// mean of the aggregated samples, starts a new decimation window
+void BME280Stream::getMean(int32_t *temperature, int32_t *pressure,
+                           int32_t *humidity) {
+  uint8_t n = (_count == 0) ? 1 : _count;
+  *temperature = _sumTemperature / n;
+  *pressure = _sumPressure / n;
+  *humidity = _sumHumidity / n;
+  _count = 0;
+  _sumTemperature = 0;
+  _sumPressure = 0;
+  _sumHumidity = 0;
+}
+
+/*
+  Forced mode: one measurement per sample, the sensor sleeps for the rest of
+  the period and the MCU stays awake for the conversion time.
+*/
+uint32_t BME280Stream::getForcedCharge_nC(BME280 &bme, uint32_t period_ms,
+                                          uint32_t mcuRun_uA) {
+  uint64_t period_us = (uint64_t)period_ms * 1000;
+  uint32_t t_meas = bme.getMeasurementTime_us();
+  uint64_t sleep_us = (period_us > t_meas) ? period_us - t_meas : 0;
+  uint64_t pC = (uint64_t)bme.getMeasurementCharge_nC() * 1000 +
+                sleep_us * BME280_SLEEP_CURRENT_NA / 1000 +
+                (uint64_t)t_meas * mcuRun_uA;
+  return (uint32_t)(pC / 1000);
+}
+
+/*
+  Normal mode: the sensor measures every t_meas + t_standby on its own, the
+  MCU reads one burst per period and never waits for a conversion.
+*/
+uint32_t BME280Stream::getNormalCharge_nC(BME280 &bme, BME280::Standby standby,
+                                          uint32_t period_ms) {
+  uint64_t period_us = (uint64_t)period_ms * 1000;
+  uint32_t t_meas = bme.getMeasurementTime_us();
+  uint32_t t_sb = BME280::getStandbyTime_us(standby);
+  uint64_t cycle_pC = (uint64_t)bme.getMeasurementCharge_nC() * 1000 +
+                      (uint64_t)t_sb * BME280_STANDBY_CURRENT_NA / 1000;
+  uint64_t pC = period_us * cycle_pC / (t_meas + t_sb);
+  return (uint32_t)(pC / 1000);
+}
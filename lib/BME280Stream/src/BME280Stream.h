@@ -0,0 +1,52 @@
+/*
+@file   BME280Stream.h
+@brief  Normal mode streaming for high rate nodes. The BME280 free runs with
+        its standby time and IIR filter, the MCU only reads the latest data
+        burst on each wake and decimates the samples into an aggregator.
+*/
+
+#ifndef _BME280_STREAM_H_
+#define _BME280_STREAM_H_
+
+#include <Arduino.h>
+#include "BME280.h"
+
+// samples averaged into one output value
+#ifndef BME280_STREAM_DECIMATION
+#define BME280_STREAM_DECIMATION 10
+#endif
+
+// BME280 supply current in sleep and standby in nA (datasheet table 1)
+#define BME280_SLEEP_CURRENT_NA 100
+#define BME280_STANDBY_CURRENT_NA 200
+
+class BME280Stream {
+
+public:
+  BME280Stream(BME280 &bme);
+
+  int begin(BME280::Standby standby = BME280::STANDBY_1000_MS,
+            BME280::Iirc iirc = BME280::IIRC_4,
+            uint8_t decimation = BME280_STREAM_DECIMATION);
+  int poll();
+  bool ready() { return _count >= _decimation; }
+  uint8_t getCount() { return _count; }
+  void getMean(int32_t *temperature, int32_t *pressure, int32_t *humidity);
+
+  // charge per output sample in nC when the MCU samples every period_ms
+  static uint32_t getForcedCharge_nC(BME280 &bme, uint32_t period_ms,
+                                     uint32_t mcuRun_uA);
+  static uint32_t getNormalCharge_nC(BME280 &bme, BME280::Standby standby,
+                                     uint32_t period_ms);
+
+private:
+  BME280 &_bme;
+  uint8_t _decimation;
+  uint8_t _count;
+  // aggregator: 0.01 degC, Pa, 0.01 %RH
+  int32_t _sumTemperature;
+  int32_t _sumPressure;
+  int32_t _sumHumidity;
+};
+
+#endif // _BME280_STREAM_H_
@@ -0,0 +1,82 @@
+/*
+@file   BusTrace.cpp
+@brief  Recording shim for the shared SPI bus
+*/
+
+#include "BusTrace.h"
+
+BusTrace BusTracer;
+
+BusTrace::BusTrace() {
+  _maxTransactions = 0;
+  _maxBytes = 0;
+  reset();
+}
+
+// a budget of 0 disables the check for that total
+void BusTrace::setBudget(uint32_t maxTransactions, uint32_t maxBytes) {
+  _maxTransactions = maxTransactions;
+  _maxBytes = maxBytes;
+}
+
+// call at the start of every sample cycle
+void BusTrace::reset() {
+  _count = 0;
+  _transactions = 0;
+  _bytes = 0;
+  _duration_ns = 0;
+}
+
+void BusTrace::record(uint8_t csPin, uint8_t reg, Direction dir, uint16_t bytes,
+                      uint32_t clockHz) {
+  // address byte + data bytes, 8 clocks each
+  uint32_t duration_ns =
+      (uint32_t)(((uint64_t)(bytes + 1) * 8 * 1000000000UL) / clockHz);
+
+  if (_count < BUS_TRACE_MAX_ENTRIES) {
+    Entry &e = _entries[_count++];
+    e.csPin = csPin;
+    e.reg = reg;
+    e.dir = dir;
+    e.bytes = bytes;
+    e.duration_ns = duration_ns;
+  }
+  _transactions++;
+  // bytes on the wire, including the address byte
+  _bytes += bytes + 1;
+  _duration_ns += duration_ns;
+}
+
+bool BusTrace::overBudget() {
+  if ((_maxTransactions != 0) && (_transactions > _maxTransactions)) {
+    return true;
+  }
+  if ((_maxBytes != 0) && (_bytes > _maxBytes)) {
+    return true;
+  }
+  return false;
+}
+
+void BusTrace::printReport(Print &out) {
+  for (uint16_t i = 0; i < _count; i++) {
+    const Entry &e = _entries[i];
+    out.print(e.csPin);
+    out.print(e.dir == BUS_WRITE ? " W 0x" : " R 0x");
+    out.print(e.reg, HEX);
+    out.print(' ');
+    out.print(e.bytes);
+    out.print(' ');
+    out.println(e.duration_ns);
+  }
+  out.print("[BUS] transactions: ");
+  out.print(_transactions);
+  out.print('/');
+  out.print(_maxTransactions);
+  out.print(" bytes: ");
+  out.print(_bytes);
+  out.print('/');
+  out.print(_maxBytes);
+  out.print(" time: ");
+  out.print(getDuration_us());
+  out.println(" us");
+}
@@ -0,0 +1,70 @@
+/*
+@file   BusTrace.h
+@brief  Recording shim for the shared SPI bus. Every chip-select session of the
+        BME280 and the SX1276 is logged with its register, direction, byte
+        count and the time it keeps the bus busy, and the totals of one sample
+        cycle are compared against a stored budget.
+*/
+
+#ifndef _BUS_TRACE_H_
+#define _BUS_TRACE_H_
+
+#include <Arduino.h>
+
+// number of sessions kept for the report, totals are counted beyond this
+#ifndef BUS_TRACE_MAX_ENTRIES
+#define BUS_TRACE_MAX_ENTRIES 64
+#endif
+
+// Bus traffic budget for one sample cycle (BME280 + SX1276), checked on the
+// node and by test/test_bus_trace. Raise it together with the change that
+// needs the traffic.
+#ifndef BUS_BUDGET_TRANSACTIONS
+#define BUS_BUDGET_TRANSACTIONS 32
+#endif
+#ifndef BUS_BUDGET_BYTES
+#define BUS_BUDGET_BYTES 160
+#endif
+
+class BusTrace {
+
+public:
+  enum Direction : uint8_t { BUS_READ, BUS_WRITE };
+
+  struct Entry {
+    uint8_t csPin;        // chip select of the session
+    uint8_t reg;          // first register address
+    Direction dir;        // read or write
+    uint16_t bytes;       // data bytes, without the address byte
+    uint32_t duration_ns; // simulated bus time for address + data
+  };
+
+  BusTrace();
+
+  void setBudget(uint32_t maxTransactions, uint32_t maxBytes);
+  void reset();
+  void record(uint8_t csPin, uint8_t reg, Direction dir, uint16_t bytes,
+              uint32_t clockHz);
+
+  uint32_t getTransactions() { return _transactions; }
+  uint32_t getBytes() { return _bytes; }
+  uint32_t getDuration_us() { return _duration_ns / 1000; }
+  uint16_t getEntryCount() { return _count; }
+  const Entry *getEntry(uint16_t i) { return (i < _count) ? &_entries[i] : NULL; }
+
+  bool overBudget();
+  void printReport(Print &out);
+
+private:
+  Entry _entries[BUS_TRACE_MAX_ENTRIES];
+  uint16_t _count;
+  uint32_t _transactions;
+  uint32_t _bytes;
+  uint32_t _duration_ns;
+  uint32_t _maxTransactions;
+  uint32_t _maxBytes;
+};
+
+extern BusTrace BusTracer;
+
+#endif // _BUS_TRACE_H_
@@ -0,0 +1,90 @@
+/*
+@file   EnergyMeter.cpp
+@brief  Awake time and charge per phase of the duty cycle
+*/
+
+#include "EnergyMeter.h"
+
+static const char *const PhaseNames[EnergyMeter::PHASE_COUNT] = {
+    "wake", "adc", "bme", "fmt", "tx", "fin", "ent", "slp"};
+
+EnergyMeter::EnergyMeter() {
+  static const uint32_t model[PHASE_COUNT] = {
+      ENERGY_CURRENT_WAKE_NA,         ENERGY_CURRENT_ADC_NA,
+      ENERGY_CURRENT_SENSOR_NA,       ENERGY_CURRENT_PAYLOAD_NA,
+      ENERGY_CURRENT_RADIO_TX_NA,     ENERGY_CURRENT_RADIO_FINISH_NA,
+      ENERGY_CURRENT_SLEEP_ENTRY_NA,  ENERGY_CURRENT_SLEEP_NA};
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    _phase[i].current_nA = model[i];
+    _phase[i].time_us = 0;
+    _phase[i].charge_nC = 0;
+  }
+}
+
+void EnergyMeter::setCurrent_nA(Phase phase, uint32_t current_nA) {
+  _phase[phase].current_nA = current_nA;
+}
+
+// charged per interval, so a model change only affects later intervals
+void EnergyMeter::charge(Phase phase, uint64_t us) {
+  _phase[phase].time_us += us;
+  _phase[phase].charge_nC +=
+      (us * _phase[phase].current_nA + 500000) / 1000000;
+}
+
+void EnergyMeter::start(Phase phase) {
+  uint32_t now = micros();
+  if (_running < PHASE_COUNT) {
+    charge(_running, now - _mark_us);
+  }
+  _running = phase;
+  _mark_us = now;
+}
+
+void EnergyMeter::suspend() {
+  if (_running < PHASE_COUNT) {
+    charge(_running, micros() - _mark_us);
+  }
+  _running = PHASE_COUNT;
+}
+
+void EnergyMeter::addTime_ms(Phase phase, uint32_t ms) {
+  charge(phase, (uint64_t)ms * 1000);
+}
+
+uint64_t EnergyMeter::getTotalTime_us() {
+  uint64_t total = 0;
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    total += _phase[i].time_us;
+  }
+  return total;
+}
+
+uint64_t EnergyMeter::getTotalCharge_nC() {
+  uint64_t total = 0;
+  for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+    total += _phase[i].charge_nC;
+  }
+  return total;
+}
+
+uint32_t EnergyMeter::getAverageCurrent_nA() {
+  uint64_t ms = getTotalTime_us() / 1000;
+  if (ms == 0) {
+    return 0;
+  }
+  return (uint32_t)(getTotalCharge_nC() * 1000 / ms);
+}
+
+uint32_t EnergyMeter::getBatteryLife_h(uint32_t capacity_mAh) {
+  uint32_t average = getAverageCurrent_nA();
+  if (average == 0) {
+    return 0;
+  }
+  // mAh to nAh
+  return (uint32_t)((uint64_t)capacity_mAh * 1000000 / average);
+}
+
+const char *EnergyMeter::getName(Phase phase) {
+  return (phase < PHASE_COUNT) ? PhaseNames[phase] : "";
+}
@@ -0,0 +1,101 @@
+/*
+@file   EnergyMeter.h
+@brief  Awake time and charge per phase of the duty cycle. The running phase
+        is timed with micros() and charged at the modelled current of that
+        phase. Stop mode halts micros(), the time spent in it is added from
+        the RTC instead, to the sleep or to a transmission still in flight.
+*/
+
+#ifndef _ENERGY_METER_H_
+#define _ENERGY_METER_H_
+
+#include <Arduino.h>
+
+/* default current model of the MiniPill LoRa in nA, MCU included */
+#ifndef ENERGY_CURRENT_WAKE_NA
+#define ENERGY_CURRENT_WAKE_NA 600000 // MCU at 2 MHz, radio and BME280 asleep
+#endif
+#ifndef ENERGY_CURRENT_ADC_NA
+#define ENERGY_CURRENT_ADC_NA 1000000 // ADC, VREFINT and sensor buffer
+#endif
+#ifndef ENERGY_CURRENT_SENSOR_NA
+#define ENERGY_CURRENT_SENSOR_NA 1300000 // BME280 forced conversion
+#endif
+#ifndef ENERGY_CURRENT_PAYLOAD_NA
+#define ENERGY_CURRENT_PAYLOAD_NA 3300000 // MCU at 16 MHz
+#endif
+#ifndef ENERGY_CURRENT_RADIO_TX_NA
+#define ENERGY_CURRENT_RADIO_TX_NA 90000000 // SX1276 PA_BOOST at +17 dBm
+#endif
+#ifndef ENERGY_CURRENT_RADIO_FINISH_NA
+#define ENERGY_CURRENT_RADIO_FINISH_NA 2200000 // SX1276 standby, MCU 16 MHz
+#endif
+#ifndef ENERGY_CURRENT_SLEEP_ENTRY_NA
+#define ENERGY_CURRENT_SLEEP_ENTRY_NA 600000
+#endif
+#ifndef ENERGY_CURRENT_SLEEP_NA
+#define ENERGY_CURRENT_SLEEP_NA 1800 // stop mode with RTC, all parts asleep
+#endif
+
+class EnergyMeter {
+
+public:
+  enum Phase : uint8_t {
+    PHASE_WAKE,         // from the wakeup to the first measurement
+    PHASE_ADC,          // VREFINT and MCU temperature scan
+    PHASE_SENSOR,       // BME280 conversion and readout
+    PHASE_PAYLOAD,      // payload formatting
+    PHASE_RADIO_TX,     // startTransmit() to the DIO0 interrupt
+    PHASE_RADIO_FINISH, // finishTransmit() and the radio back to sleep
+    PHASE_SLEEP_ENTRY,  // log flush and power hooks before stop mode
+    PHASE_SLEEP,        // stop mode
+    PHASE_COUNT
+  };
+
+  EnergyMeter();
+
+  void setCurrent_nA(Phase phase, uint32_t current_nA);
+
+  // charges the running phase up to now, then phase runs
+  void start(Phase phase);
+  // charges the running phase, nothing runs until the next start()
+  void suspend();
+  // time of a phase measured outside micros(), e.g. on the RTC
+  void addTime_ms(Phase phase, uint32_t ms);
+  void addSleep_ms(uint32_t ms) { addTime_ms(PHASE_SLEEP, ms); }
+  // one sample packet of the duty cycle
+  void countCycle() { _cycles++; }
+
+  // PHASE_COUNT while suspended
+  Phase getPhase() { return _running; }
+
+  uint64_t getTime_us(Phase phase) { return _phase[phase].time_us; }
+  uint64_t getCharge_nC(Phase phase) { return _phase[phase].charge_nC; }
+  uint64_t getTotalTime_us();
+  uint64_t getTotalCharge_nC();
+  uint32_t getCycles() { return _cycles; }
+
+  // mean current over all phases
+  uint32_t getAverageCurrent_nA();
+  // hours a battery of capacity_mAh lasts at the mean current
+  uint32_t getBatteryLife_h(uint32_t capacity_mAh);
+
+  // short name, used as JSON key
+  static const char *getName(Phase phase);
+
+private:
+  void charge(Phase phase, uint64_t us);
+
+  struct Account {
+    uint32_t current_nA;
+    uint64_t time_us;
+    uint64_t charge_nC;
+  };
+
+  Account _phase[PHASE_COUNT];
+  Phase _running = PHASE_COUNT; // PHASE_COUNT while suspended
+  uint32_t _mark_us = 0;
+  uint32_t _cycles = 0;
+};
+
+#endif // _ENERGY_METER_H_
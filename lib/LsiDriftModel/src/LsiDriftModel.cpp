@@ -0,0 +1,83 @@
+/*
+@file   LsiDriftModel.cpp
+@brief  Temperature model of the LSI correction factor
+*/
+
+#include "LsiDriftModel.h"
+
+void LsiDriftModel::reset() {
+  _count = 0;
+  _next = 0;
+  _predictions = 0;
+  _fitted = false;
+}
+
+// the oldest point is replaced
+void LsiDriftModel::add(int32_t temperature, uint32_t correctionQ16) {
+  _points[_next] = {temperature, correctionQ16};
+  _next = (_next + 1) % LSI_DRIFT_POINTS;
+  if (_count < LSI_DRIFT_POINTS) {
+    _count++;
+  }
+  _predictions = 0;
+  fit();
+}
+
+bool LsiDriftModel::needsCalibration(int32_t temperature) {
+  if ((_count == 0) || (_predictions >= LSI_DRIFT_MAX_PREDICTIONS)) {
+    return true;
+  }
+  for (uint8_t i = 0; i < _count; i++) {
+    int32_t d = temperature - _points[i].temperature;
+    if ((d <= LSI_DRIFT_TEMP_STEP) && (d >= -LSI_DRIFT_TEMP_STEP)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32_t LsiDriftModel::predict(int32_t temperature) {
+  if (!_fitted) {
+    return 1UL << 16;
+  }
+  if (_predictions < LSI_DRIFT_MAX_PREDICTIONS) {
+    _predictions++;
+  }
+  int64_t c = _mean + ((_slope * (temperature - _meanT)) >> 16);
+  return (c > 0) ? (uint32_t)c : 1;
+}
+
+int32_t LsiDriftModel::getSlope_ppm() {
+  // 16.16 per 0.01 degC (x 2^16) to ppm per degC
+  return _fitted ? (int32_t)((_slope * 100 * 1000000) >> 32) : 0;
+}
+
+/*
+  Least squares line through the points, around the mean temperature so
+  the sums stay small. With too little spread the slope is left at 0 and
+  the model is the mean correction.
+*/
+void LsiDriftModel::fit() {
+  int64_t sumT = 0;
+  int64_t sumC = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    sumT += _points[i].temperature;
+    sumC += _points[i].correctionQ16;
+  }
+  _meanT = (int32_t)(sumT / _count);
+  _mean = sumC / _count;
+
+  int64_t sxx = 0;
+  int64_t sxy = 0;
+  int32_t minT = _points[0].temperature;
+  int32_t maxT = minT;
+  for (uint8_t i = 0; i < _count; i++) {
+    int64_t dt = _points[i].temperature - _meanT;
+    sxx += dt * dt;
+    sxy += dt * ((int64_t)_points[i].correctionQ16 - _mean);
+    minT = min(minT, _points[i].temperature);
+    maxT = max(maxT, _points[i].temperature);
+  }
+  _slope = ((maxT - minT) >= LSI_DRIFT_MIN_SPREAD) ? (sxy << 16) / sxx : 0;
+  _fitted = true;
+}
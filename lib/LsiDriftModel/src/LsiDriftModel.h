@@ -0,0 +1,66 @@
+/*
+@file   LsiDriftModel.h
+@brief  Linear model of the LSI correction factor over temperature, fitted
+        by least squares to the last calibrations. Predicts the correction
+        for the current temperature and asks for a new calibration only when
+        the temperature leaves the range it has seen.
+*/
+
+#ifndef _LSI_DRIFT_MODEL_H_
+#define _LSI_DRIFT_MODEL_H_
+
+#include <Arduino.h>
+
+// calibrations kept for the fit
+#ifndef LSI_DRIFT_POINTS
+#define LSI_DRIFT_POINTS 8
+#endif
+
+// a calibration is due this far from the nearest point, 0.01 degC
+#ifndef LSI_DRIFT_TEMP_STEP
+#define LSI_DRIFT_TEMP_STEP 200
+#endif
+
+// and after this many predictions, for aging and supply changes
+#ifndef LSI_DRIFT_MAX_PREDICTIONS
+#define LSI_DRIFT_MAX_PREDICTIONS 360
+#endif
+
+// a spread below this fits no slope, 0.01 degC
+#define LSI_DRIFT_MIN_SPREAD 100
+
+class LsiDriftModel {
+
+public:
+  void reset();
+
+  // temperature in 0.01 degC, correction in 16.16 fixed point
+  void add(int32_t temperature, uint32_t correctionQ16);
+  bool needsCalibration(int32_t temperature);
+  uint32_t predict(int32_t temperature);
+
+  uint8_t getCount() { return _count; }
+  // fitted slope in ppm per degC
+  int32_t getSlope_ppm();
+
+private:
+  struct Point {
+    int32_t temperature;
+    uint32_t correctionQ16;
+  };
+
+  Point _points[LSI_DRIFT_POINTS];
+  uint8_t _count = 0;
+  uint8_t _next = 0;
+  uint16_t _predictions = 0;
+
+  // fit: correction = _mean + _slope * (temperature - _meanT) / 2^16
+  bool _fitted = false;
+  int32_t _meanT;
+  int64_t _mean;  // 16.16
+  int64_t _slope; // 16.16 per 0.01 degC, scaled by 2^16
+
+  void fit();
+};
+
+#endif // _LSI_DRIFT_MODEL_H_
@@ -0,0 +1,95 @@
+/*
+@file   PayloadWriter.cpp
+@brief  Appends text and integers to a fixed size character buffer
+*/
+
+#include "PayloadWriter.h"
+
+PayloadWriter::PayloadWriter(char *buf, size_t size)
+    : _buf(buf), _size(size) {
+  clear();
+}
+
+void PayloadWriter::clear() {
+  _len = 0;
+  _overflow = false;
+  if (_size > 0) {
+    _buf[0] = '\0';
+  }
+}
+
+PayloadWriter &PayloadWriter::add(const char *text, size_t len) {
+  // keep one byte for the terminator
+  size_t room = _size > _len ? _size - _len - 1 : 0;
+  if (len > room) {
+    len = room;
+    _overflow = true;
+  }
+  memcpy(_buf + _len, text, len);
+  _len += len;
+  if (_size > 0) {
+    _buf[_len] = '\0';
+  }
+  return *this;
+}
+
+PayloadWriter &PayloadWriter::add(const char *text) {
+  return add(text, strlen(text));
+}
+
+PayloadWriter &PayloadWriter::add(char c) { return add(&c, 1); }
+
+PayloadWriter &PayloadWriter::add(int32_t value) {
+  char digits[11];
+  return add(digits, formatI32(digits, value));
+}
+
+PayloadWriter &PayloadWriter::add(uint32_t value) {
+  char digits[11];
+  return add(digits, formatU32(digits, value));
+}
+
+/*
+  The Cortex-M0+ has neither a divide instruction nor a 32x32->64 multiply,
+  so GCC turns value / 10 into an __aeabi_uidiv call per digit. The quotient
+  is built from shifts and adds instead (Hacker's Delight, divu10) and the
+  remainder corrects the estimate, which is at most one too small.
+*/
+static inline uint32_t divu10(uint32_t n, uint32_t *rem) {
+  uint32_t q = (n >> 1) + (n >> 2);
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q >>= 3;
+  uint32_t r = n - (((q << 2) + q) << 1);
+  if (r > 9) {
+    q++;
+    r -= 10;
+  }
+  *rem = r;
+  return q;
+}
+
+uint8_t PayloadWriter::formatU32(char *out, uint32_t value) {
+  // digits are produced from the right
+  char tmp[10];
+  uint8_t n = 0;
+  do {
+    uint32_t digit;
+    value = divu10(value, &digit);
+    tmp[n++] = '0' + (char)digit;
+  } while (value != 0);
+  for (uint8_t i = 0; i < n; i++) {
+    out[i] = tmp[n - 1 - i];
+  }
+  return n;
+}
+
+uint8_t PayloadWriter::formatI32(char *out, int32_t value) {
+  if (value >= 0) {
+    return formatU32(out, (uint32_t)value);
+  }
+  out[0] = '-';
+  // the negation is done unsigned so INT32_MIN does not overflow
+  return 1 + formatU32(out + 1, 0u - (uint32_t)value);
+}
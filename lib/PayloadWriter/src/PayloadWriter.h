@@ -0,0 +1,44 @@
+/*
+@file   PayloadWriter.h
+@brief  Appends text and integers to a caller owned, fixed size character
+        buffer. Replaces String concatenation on the packet paths, nothing is
+        allocated and the result is always terminated.
+*/
+
+#ifndef _PAYLOAD_WRITER_H_
+#define _PAYLOAD_WRITER_H_
+
+#include <Arduino.h>
+
+class PayloadWriter {
+
+public:
+  PayloadWriter(char *buf, size_t size);
+
+  void clear();
+
+  PayloadWriter &add(const char *text);
+  PayloadWriter &add(char c);
+  PayloadWriter &add(int32_t value);
+  PayloadWriter &add(uint32_t value);
+
+  const char *c_str() { return _buf; }
+  size_t length() { return _len; }
+  // true when something did not fit, the text is then cut off
+  bool overflow() { return _overflow; }
+
+  // decimal digits of value into out (at least 11 bytes), not terminated,
+  // returns the number of characters
+  static uint8_t formatU32(char *out, uint32_t value);
+  static uint8_t formatI32(char *out, int32_t value);
+
+private:
+  PayloadWriter &add(const char *text, size_t len);
+
+  char *_buf;
+  size_t _size;
+  size_t _len;
+  bool _overflow;
+};
+
+#endif // _PAYLOAD_WRITER_H_
@@ -0,0 +1,15 @@
+/*
+@file   RadioSettings.cpp
+@brief  Hands the integer settings to RadioLib. SX1276::begin() takes the
+        frequency and bandwidth as float, so the conversion is kept in this
+        one translation unit, which the soft-float check allowlists.
+*/
+
+#include "RadioSettings.h"
+
+int16_t beginSX127x(SX1276 &radio, const RadioSettings &settings) {
+  return radio.begin(settings.frequency_kHz / 1000.0f,
+                     settings.bandwidth_100Hz / 10.0f, settings.spreadingFactor,
+                     settings.codingRate, settings.syncWord, settings.power,
+                     settings.preambleLength, settings.gain);
+}
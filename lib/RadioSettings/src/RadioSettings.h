@@ -0,0 +1,27 @@
+/*
+@file   RadioSettings.h
+@brief  LoRa modulation settings in integer units, as passed to
+        SX1276::begin()
+*/
+
+#ifndef _RADIO_SETTINGS_H_
+#define _RADIO_SETTINGS_H_
+
+#include <Arduino.h>
+#include <RadioLib.h>
+
+struct RadioSettings {
+  uint32_t frequency_kHz;
+  uint16_t bandwidth_100Hz;
+  uint8_t spreadingFactor;
+  uint8_t codingRate;
+  uint8_t syncWord;
+  int8_t power;
+  uint16_t preambleLength;
+  uint8_t gain;
+};
+
+// SX1276::begin() with the settings converted to RadioLib units
+int16_t beginSX127x(SX1276 &radio, const RadioSettings &settings);
+
+#endif // _RADIO_SETTINGS_H_
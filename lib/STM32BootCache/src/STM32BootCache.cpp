@@ -0,0 +1,70 @@
+/*
+@file   STM32BootCache.cpp
+@brief  Warm boot record in the data EEPROM
+*/
+
+#include "STM32BootCache.h"
+#include "STM32DataEEPROM.h"
+
+#define BOOT_CACHE_MAGIC 0x42435348
+
+STM32BootCache BootCache;
+
+/*
+  True after a power-on, power-down or brownout reset. The reset flags stay
+  set until they are cleared, so they are cleared here for the next reset
+  to be told apart. A standby wakeup sets none of them.
+*/
+static bool powerOnReset() {
+  bool powerOn = (__HAL_RCC_GET_FLAG(RCC_FLAG_PORRST) != RESET);
+#ifdef RCC_FLAG_BORRST
+  powerOn = powerOn || (__HAL_RCC_GET_FLAG(RCC_FLAG_BORRST) != RESET);
+#endif
+  __HAL_RCC_CLEAR_RESET_FLAGS();
+  return powerOn;
+}
+
+/*
+  Returns true when the reset was not a power-on reset and the record is
+  intact, has the current layout and was written by the same firmware
+  build. A new build and a power cycle always boot cold, the supply or the
+  sensor may have changed. Call once per boot, it clears the reset flags.
+*/
+bool STM32BootCache::load(uint32_t buildId) {
+  Record rec;
+
+  if (powerOnReset()) {
+    return false;
+  }
+  DataEEPROM.read(BOOT_CACHE_OFFSET, &rec, sizeof(rec));
+  if ((rec.magic != BOOT_CACHE_MAGIC) || (rec.version != BOOT_CACHE_VERSION) ||
+      (rec.length != sizeof(rec)) || (rec.buildId != buildId)) {
+    return false;
+  }
+  if (STM32DataEEPROM::crc32(&rec, offsetof(Record, crc)) != rec.crc) {
+    return false;
+  }
+  trimming = rec.trimming;
+  rtcCorrectionQ16 = rec.rtcCorrectionQ16;
+  return true;
+}
+
+bool STM32BootCache::save(uint32_t buildId) {
+  Record rec;
+
+  memset(&rec, 0, sizeof(rec));
+  rec.magic = BOOT_CACHE_MAGIC;
+  rec.version = BOOT_CACHE_VERSION;
+  rec.length = sizeof(rec);
+  rec.buildId = buildId;
+  rec.trimming = trimming;
+  rec.rtcCorrectionQ16 = rtcCorrectionQ16;
+  rec.crc = STM32DataEEPROM::crc32(&rec, offsetof(Record, crc));
+  return DataEEPROM.write(BOOT_CACHE_OFFSET, &rec, sizeof(rec));
+}
+
+// forces the next boot to run the full calibration and init sequence
+void STM32BootCache::invalidate() {
+  uint32_t magic = 0;
+  DataEEPROM.write(BOOT_CACHE_OFFSET, &magic, sizeof(magic));
+}
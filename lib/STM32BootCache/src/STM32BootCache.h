@@ -0,0 +1,47 @@
+/*
+@file   STM32BootCache.h
+@brief  Versioned, CRC protected record in the data EEPROM with the results
+        of the slow boot steps (BME280 trimming, RTC correction) so a warm
+        reset (watchdog, software or pin reset) can skip them
+*/
+
+#ifndef _STM32_BOOT_CACHE_H_
+#define _STM32_BOOT_CACHE_H_
+
+#include <Arduino.h>
+#include "BME280.h"
+
+// record location in the data EEPROM
+#define BOOT_CACHE_OFFSET 0
+#define BOOT_CACHE_SIZE 128
+
+// increase when the record layout changes
+#define BOOT_CACHE_VERSION 2
+
+class STM32BootCache {
+
+public:
+  bool load(uint32_t buildId);
+  bool save(uint32_t buildId);
+  void invalidate();
+
+  BME280::Trimming trimming;
+  uint32_t rtcCorrectionQ16; // RTC time correction factor, 16.16 fixed point
+
+private:
+  struct Record {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;
+    uint32_t buildId;
+    BME280::Trimming trimming;
+    uint32_t rtcCorrectionQ16;
+    uint32_t crc;
+  };
+  static_assert(sizeof(Record) <= BOOT_CACHE_SIZE,
+                "boot cache record does not fit BOOT_CACHE_SIZE");
+};
+
+extern STM32BootCache BootCache;
+
+#endif // _STM32_BOOT_CACHE_H_
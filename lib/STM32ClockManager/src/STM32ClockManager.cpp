@@ -0,0 +1,208 @@
+/*
+@file   STM32ClockManager.cpp
+@brief  System clock profiles for the STM32L0
+*/
+
+#include "STM32ClockManager.h"
+
+STM32ClockManager ClockManager;
+
+/*
+  Dynamic range and flash wait states per profile (RM0377, 3.7.1 and
+  6.1.4): range 3 (1.2 V) up to 4.2 MHz without wait state, range 2 (1.5 V)
+  needs one wait state above 8 MHz, range 1 (1.8 V) up to 32 MHz.
+*/
+static const struct {
+  uint32_t hz;
+  uint32_t voltage;
+  uint32_t latency;
+} profiles[CLOCK_PROFILES] = {
+    {65536, PWR_REGULATOR_VOLTAGE_SCALE3, FLASH_LATENCY_0},
+    {2097152, PWR_REGULATOR_VOLTAGE_SCALE3, FLASH_LATENCY_0},
+    {16000000, PWR_REGULATOR_VOLTAGE_SCALE2, FLASH_LATENCY_1},
+    {32000000, PWR_REGULATOR_VOLTAGE_SCALE1, FLASH_LATENCY_1},
+};
+
+static void setVoltageRange(uint32_t voltage) {
+  __HAL_PWR_VOLTAGESCALING_CONFIG(voltage);
+  while (__HAL_PWR_GET_FLAG(PWR_FLAG_VOS)) {
+  }
+}
+
+// profile used when nothing is requested
+void STM32ClockManager::setBase(ClockProfile profile) {
+  if (profile < CLOCK_PROFILES) {
+    _base = profile;
+    update();
+  }
+}
+
+void STM32ClockManager::request(ClockProfile profile) {
+  if ((profile < CLOCK_PROFILES) && (_requests[profile] < 0xFF)) {
+    _requests[profile]++;
+    update();
+  }
+}
+
+void STM32ClockManager::release(ClockProfile profile) {
+  if ((profile < CLOCK_PROFILES) && (_requests[profile] > 0)) {
+    _requests[profile]--;
+    update();
+  }
+}
+
+// the clocks are reset on a wakeup from stop mode, sets the profile again
+void STM32ClockManager::restore() {
+  ClockProfile profile = _current;
+  _current = CLOCK_PROFILES;
+  if (!apply(profile)) {
+    SystemClock_Config();
+    _current = CLOCK_PLL_32M;
+  }
+}
+
+static bool addCallback(clockChangeCallback *list,
+                        clockChangeCallback callback) {
+  for (uint8_t i = 0; i < CLOCK_MANAGER_MAX_CALLBACKS; i++) {
+    if (list[i] == nullptr) {
+      list[i] = callback;
+      return true;
+    }
+  }
+  return false;
+}
+
+static void runCallbacks(clockChangeCallback *list, uint32_t hz) {
+  for (uint8_t i = 0; i < CLOCK_MANAGER_MAX_CALLBACKS; i++) {
+    if (list[i] != nullptr) {
+      list[i](hz);
+    }
+  }
+}
+
+bool STM32ClockManager::onBeforeChange(clockChangeCallback callback) {
+  return addCallback(_before, callback);
+}
+
+bool STM32ClockManager::onChange(clockChangeCallback callback) {
+  return addCallback(_callbacks, callback);
+}
+
+uint32_t STM32ClockManager::getFrequency() {
+  return (_current < CLOCK_PROFILES) ? profiles[_current].hz : SystemCoreClock;
+}
+
+void STM32ClockManager::update() {
+  ClockProfile target = _base;
+  for (uint8_t p = target + 1; p < CLOCK_PROFILES; p++) {
+    if (_requests[p] > 0) {
+      target = (ClockProfile)p;
+    }
+  }
+  if (target == _current) {
+    return;
+  }
+  // the peripherals must stay usable at the old clock if apply() fails
+  runCallbacks(_before, profiles[target].hz);
+  if (apply(target)) {
+    runCallbacks(_callbacks, profiles[target].hz);
+  }
+}
+
+/*
+  The voltage range goes up before and down after the clock switch,
+  HAL_RCC_ClockConfig() orders the flash wait states the same way.
+*/
+bool STM32ClockManager::apply(ClockProfile profile) {
+  RCC_OscInitTypeDef osc = {};
+  RCC_ClkInitTypeDef clk = {};
+
+  if (READ_BIT(PWR->CR, PWR_CR_LPRUN)) {
+    HAL_PWREx_DisableLowPowerRunMode();
+  }
+  if (profiles[profile].voltage < (PWR->CR & PWR_CR_VOS)) {
+    setVoltageRange(profiles[profile].voltage);
+  }
+
+  switch (profile) {
+  case CLOCK_MSI_65K:
+  case CLOCK_MSI_2M:
+    osc.OscillatorType = RCC_OSCILLATORTYPE_MSI;
+    osc.MSIState = RCC_MSI_ON;
+    osc.MSICalibrationValue = RCC_MSICALIBRATION_DEFAULT;
+    osc.MSIClockRange =
+        (profile == CLOCK_MSI_65K) ? RCC_MSIRANGE_0 : RCC_MSIRANGE_5;
+    clk.SYSCLKSource = RCC_SYSCLKSOURCE_MSI;
+    break;
+  case CLOCK_HSI16:
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+    osc.HSIState = RCC_HSI_ON;
+    osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+    clk.SYSCLKSource = RCC_SYSCLKSOURCE_HSI;
+    break;
+  default:
+    // 16 MHz HSI * 4 / 2
+    osc.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+    osc.HSIState = RCC_HSI_ON;
+    osc.HSICalibrationValue = RCC_HSICALIBRATION_DEFAULT;
+    osc.PLL.PLLState = RCC_PLL_ON;
+    osc.PLL.PLLSource = RCC_PLLSOURCE_HSI;
+    osc.PLL.PLLMUL = RCC_PLL_MUL4;
+    osc.PLL.PLLDIV = RCC_PLL_DIV2;
+    clk.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
+    break;
+  }
+  if (profile != CLOCK_PLL_32M) {
+    osc.PLL.PLLState = RCC_PLL_NONE;
+  }
+  if (HAL_RCC_OscConfig(&osc) != HAL_OK) {
+    return false;
+  }
+
+  clk.ClockType = RCC_CLOCKTYPE_HCLK | RCC_CLOCKTYPE_SYSCLK |
+                  RCC_CLOCKTYPE_PCLK1 | RCC_CLOCKTYPE_PCLK2;
+  clk.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  clk.APB1CLKDivider = RCC_HCLK_DIV1;
+  clk.APB2CLKDivider = RCC_HCLK_DIV1;
+  if (HAL_RCC_ClockConfig(&clk, profiles[profile].latency) != HAL_OK) {
+    return false;
+  }
+
+  // the PLL is not needed below 32 MHz and the HSI not on the MSI, the ADC
+  // runs from PCLK
+  if (profile != CLOCK_PLL_32M) {
+    RCC_OscInitTypeDef off = {};
+    off.OscillatorType = RCC_OSCILLATORTYPE_NONE;
+    off.PLL.PLLState = RCC_PLL_OFF;
+    if (profile < CLOCK_HSI16) {
+      off.OscillatorType = RCC_OSCILLATORTYPE_HSI;
+      off.HSIState = RCC_HSI_OFF;
+    }
+    HAL_RCC_OscConfig(&off);
+  }
+
+  if (profiles[profile].voltage > (PWR->CR & PWR_CR_VOS)) {
+    setVoltageRange(profiles[profile].voltage);
+  }
+
+  // a 1 ms tick does not fit in 65 cycles, low-power run also needs the
+  // low-power regulator
+  if (profile == CLOCK_MSI_65K) {
+    HAL_SuspendTick();
+    HAL_PWREx_EnableLowPowerRunMode();
+  } else {
+    HAL_ResumeTick();
+  }
+
+  _current = profile;
+  return true;
+}
+
+#ifdef USE_CLOCK_PROFILES
+// wakeup from stop mode restores the current profile instead of the full
+// system clock
+extern "C" void SystemClock_ConfigFromStop(void) {
+  configIPClock();
+  ClockManager.restore();
+}
+#endif
@@ -0,0 +1,72 @@
+/*
+@file   STM32ClockManager.h
+@brief  Named system clock profiles for the STM32L0 with matching voltage
+        range and flash wait states. Code that needs a minimum clock holds a
+        ClockScope, the manager runs the highest requested profile or the
+        base profile and only switches when that changes.
+*/
+
+#ifndef _STM32_CLOCK_MANAGER_H_
+#define _STM32_CLOCK_MANAGER_H_
+
+#include <Arduino.h>
+
+// ordered by frequency
+enum ClockProfile : uint8_t {
+  CLOCK_MSI_65K, // low-power run, SysTick is suspended (no delay()/millis())
+  CLOCK_MSI_2M,
+  CLOCK_HSI16,
+  CLOCK_PLL_32M, // the default Arduino system clock
+  CLOCK_PROFILES
+};
+
+#define CLOCK_MANAGER_MAX_CALLBACKS 4
+
+typedef void (*clockChangeCallback)(uint32_t hz);
+
+class STM32ClockManager {
+
+public:
+  void setBase(ClockProfile profile);
+  void request(ClockProfile profile);
+  void release(ClockProfile profile);
+  void restore();
+
+  // called before every switch with the new frequency, e.g. to let a
+  // Serial finish sending at the old baud rate
+  bool onBeforeChange(clockChangeCallback callback);
+  // called after every switch, e.g. to begin() a Serial or SPI again
+  bool onChange(clockChangeCallback callback);
+
+  ClockProfile getProfile() { return _current; }
+  uint32_t getFrequency();
+
+private:
+  ClockProfile _base = CLOCK_PLL_32M;
+  ClockProfile _current = CLOCK_PLL_32M;
+  uint8_t _requests[CLOCK_PROFILES] = {0};
+  clockChangeCallback _before[CLOCK_MANAGER_MAX_CALLBACKS] = {nullptr};
+  clockChangeCallback _callbacks[CLOCK_MANAGER_MAX_CALLBACKS] = {nullptr};
+
+  void update();
+  bool apply(ClockProfile profile);
+};
+
+extern STM32ClockManager ClockManager;
+
+// requests a minimum clock profile for the lifetime of the object
+class ClockScope {
+public:
+  ClockScope(ClockProfile profile) : _profile(profile) {
+    ClockManager.request(profile);
+  }
+  ~ClockScope() { ClockManager.release(_profile); }
+
+  ClockScope(const ClockScope &) = delete;
+  void operator=(const ClockScope &) = delete;
+
+private:
+  ClockProfile _profile;
+};
+
+#endif // _STM32_CLOCK_MANAGER_H_
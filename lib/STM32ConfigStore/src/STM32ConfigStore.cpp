@@ -0,0 +1,185 @@
+/*
+@file   STM32ConfigStore.cpp
+@brief  Wear-leveled key-value store in the data EEPROM
+*/
+
+#include "STM32ConfigStore.h"
+
+#define NO_SLOT 0xFF
+
+STM32ConfigStore ConfigStore;
+
+/*
+  Scans the log once and indexes the newest intact record of every key. A
+  record torn by a reset fails its check and the previous one stays valid.
+*/
+void STM32ConfigStore::begin() {
+  uint32_t seqs[CONFIG_STORE_MAX_KEYS];
+  uint32_t newest = 0;
+  Slot rec;
+
+  memset(_index, NO_SLOT, sizeof(_index));
+  _head = 0;
+  for (uint8_t slot = 0; slot < CONFIG_STORE_SLOTS; slot++) {
+    if (!readSlot(slot, &rec)) {
+      continue;
+    }
+    if ((_index[rec.key] == NO_SLOT) || (rec.seq > seqs[rec.key])) {
+      _index[rec.key] = slot;
+      seqs[rec.key] = rec.seq;
+    }
+    if (rec.seq > newest) {
+      newest = rec.seq;
+      _head = (slot + 1) % CONFIG_STORE_SLOTS;
+    }
+  }
+  _seq = newest + 1;
+  _loaded = true;
+}
+
+// erases the log, all keys read their defaults afterwards
+void STM32ConfigStore::format() {
+  uint8_t zero[CONFIG_STORE_SLOT_SIZE];
+
+  memset(zero, 0, sizeof(zero));
+  for (uint8_t slot = 0; slot < CONFIG_STORE_SLOTS; slot++) {
+    DataEEPROM.write(CONFIG_STORE_OFFSET + slot * CONFIG_STORE_SLOT_SIZE, zero,
+                     sizeof(zero));
+  }
+  memset(_index, NO_SLOT, sizeof(_index));
+  _head = 0;
+  _seq = 1;
+  _loaded = true;
+}
+
+bool STM32ConfigStore::has(uint8_t key) {
+  if (!_loaded) {
+    begin();
+  }
+  return (key > 0) && (key < CONFIG_STORE_MAX_KEYS) &&
+         (_index[key] != NO_SLOT);
+}
+
+bool STM32ConfigStore::get(uint8_t key, void *value, uint8_t len) {
+  uint8_t buf[CONFIG_STORE_VALUE_SIZE];
+
+  if ((len > sizeof(buf)) || (read(key, buf, sizeof(buf)) != len)) {
+    return false;
+  }
+  memcpy(value, buf, len);
+  return true;
+}
+
+/*
+  Appends a record at the head of the log. Slots that hold the latest record
+  of a key are skipped, so the log only wraps over superseded records. An
+  unchanged value is not written again.
+*/
+bool STM32ConfigStore::set(uint8_t key, const void *value, uint8_t len) {
+  uint8_t buf[CONFIG_STORE_VALUE_SIZE];
+  Slot rec;
+
+  if ((key == 0) || (key >= CONFIG_STORE_MAX_KEYS) ||
+      (len > CONFIG_STORE_VALUE_SIZE)) {
+    return false;
+  }
+  if ((read(key, buf, sizeof(buf)) == len) && (memcmp(buf, value, len) == 0)) {
+    return true;
+  }
+
+  uint8_t slot = _head;
+  for (uint8_t i = 0; i < CONFIG_STORE_SLOTS; i++) {
+    if (!readSlot(slot, &rec) || (_index[rec.key] != slot)) {
+      break;
+    }
+    slot = (slot + 1) % CONFIG_STORE_SLOTS;
+  }
+
+  memset(&rec, 0, sizeof(rec));
+  rec.seq = _seq;
+  rec.key = key;
+  rec.len = len;
+  memcpy(rec.value, value, len);
+  rec.check = check(rec);
+  if (!DataEEPROM.write(CONFIG_STORE_OFFSET + slot * CONFIG_STORE_SLOT_SIZE,
+                        &rec, sizeof(rec))) {
+    return false;
+  }
+
+  _index[key] = slot;
+  _head = (slot + 1) % CONFIG_STORE_SLOTS;
+  _seq++;
+  return true;
+}
+
+uint32_t STM32ConfigStore::getU32(uint8_t key, uint32_t def) {
+  uint32_t value;
+  return get(key, &value, sizeof(value)) ? value : def;
+}
+
+int32_t STM32ConfigStore::getI32(uint8_t key, int32_t def) {
+  int32_t value;
+  return get(key, &value, sizeof(value)) ? value : def;
+}
+
+// strings are stored without the terminator, returns false when def is used
+bool STM32ConfigStore::getString(uint8_t key, char *buf, size_t size,
+                                 const char *def) {
+  char value[CONFIG_STORE_VALUE_SIZE];
+  uint8_t len = read(key, value, sizeof(value));
+
+  if (size == 0) {
+    return false;
+  }
+  if (len == 0) {
+    strncpy(buf, def, size - 1);
+    buf[size - 1] = '\0';
+    return false;
+  }
+  if (len > size - 1) {
+    len = size - 1;
+  }
+  memcpy(buf, value, len);
+  buf[len] = '\0';
+  return true;
+}
+
+bool STM32ConfigStore::setU32(uint8_t key, uint32_t value) {
+  return set(key, &value, sizeof(value));
+}
+
+bool STM32ConfigStore::setI32(uint8_t key, int32_t value) {
+  return set(key, &value, sizeof(value));
+}
+
+bool STM32ConfigStore::setString(uint8_t key, const char *value) {
+  size_t len = strlen(value);
+  if ((len == 0) || (len > CONFIG_STORE_VALUE_SIZE)) {
+    return false;
+  }
+  return set(key, value, len);
+}
+
+bool STM32ConfigStore::readSlot(uint8_t slot, Slot *rec) {
+  DataEEPROM.read(CONFIG_STORE_OFFSET + slot * CONFIG_STORE_SLOT_SIZE, rec,
+                  sizeof(*rec));
+  return (rec->seq != 0) && (rec->key > 0) &&
+         (rec->key < CONFIG_STORE_MAX_KEYS) &&
+         (rec->len <= CONFIG_STORE_VALUE_SIZE) && (rec->check == check(*rec));
+}
+
+// copies the value of key into value and returns its stored length, 0 when
+// the key has no record
+uint8_t STM32ConfigStore::read(uint8_t key, void *value, uint8_t size) {
+  Slot rec;
+
+  if (!has(key) || !readSlot(_index[key], &rec) || (rec.key != key)) {
+    return 0;
+  }
+  memcpy(value, rec.value, (rec.len < size) ? rec.len : size);
+  return rec.len;
+}
+
+uint16_t STM32ConfigStore::check(const Slot &rec) {
+  return (uint16_t)STM32DataEEPROM::crc32(&rec, offsetof(Slot, check));
+}
@@ -0,0 +1,75 @@
+/*
+@file   STM32ConfigStore.h
+@brief  Wear-leveled key-value store for the node tunables in the data
+        EEPROM. Every update appends a CRC checked record to a circular log,
+        a RAM index keeps the lookup of a key constant time.
+*/
+
+#ifndef _STM32_CONFIG_STORE_H_
+#define _STM32_CONFIG_STORE_H_
+
+#include "STM32DataEEPROM.h"
+
+// log location in the data EEPROM, the boot cache uses the first 128 bytes
+#define CONFIG_STORE_OFFSET 128
+#define CONFIG_STORE_END DATA_EEPROM_SIZE
+
+#define CONFIG_STORE_SLOT_SIZE 16
+#define CONFIG_STORE_SLOTS                                                     \
+  ((CONFIG_STORE_END - CONFIG_STORE_OFFSET) / CONFIG_STORE_SLOT_SIZE)
+
+// largest value of one key in bytes
+#define CONFIG_STORE_VALUE_SIZE 8
+
+// keys are 1 .. CONFIG_STORE_MAX_KEYS - 1, key 0 is not used
+#define CONFIG_STORE_MAX_KEYS 32
+
+class STM32ConfigStore {
+
+public:
+  void begin();
+  void format();
+
+  bool has(uint8_t key);
+  bool get(uint8_t key, void *value, uint8_t len);
+  bool set(uint8_t key, const void *value, uint8_t len);
+
+  uint32_t getU32(uint8_t key, uint32_t def);
+  int32_t getI32(uint8_t key, int32_t def);
+  bool getString(uint8_t key, char *buf, size_t size, const char *def);
+
+  bool setU32(uint8_t key, uint32_t value);
+  bool setI32(uint8_t key, int32_t value);
+  bool setString(uint8_t key, const char *value);
+
+  // number of records written since the store was formatted
+  uint32_t getSequence() { return _seq - 1; }
+
+private:
+  struct Slot {
+    uint32_t seq; // increases with every record, 0 is never written
+    uint8_t key;
+    uint8_t len;
+    uint8_t value[CONFIG_STORE_VALUE_SIZE];
+    uint16_t check; // low half of the CRC-32, the last word programmed
+  };
+  static_assert(sizeof(Slot) == CONFIG_STORE_SLOT_SIZE,
+                "config store record does not match the slot size");
+  static_assert(CONFIG_STORE_SLOTS < 0xFF,
+                "config store slot numbers do not fit in the index");
+  static_assert(CONFIG_STORE_SLOTS > CONFIG_STORE_MAX_KEYS,
+                "config store log is too small for the key count");
+
+  uint8_t _index[CONFIG_STORE_MAX_KEYS]; // slot of the latest record per key
+  uint8_t _head = 0;                     // next slot to write
+  uint32_t _seq = 1;
+  bool _loaded = false;
+
+  bool readSlot(uint8_t slot, Slot *rec);
+  uint8_t read(uint8_t key, void *value, uint8_t size);
+  static uint16_t check(const Slot &rec);
+};
+
+extern STM32ConfigStore ConfigStore;
+
+#endif // _STM32_CONFIG_STORE_H_
@@ -0,0 +1,112 @@
+/*
+@file   STM32DataEEPROM.cpp
+@brief  Access to the STM32L0 data EEPROM
+*/
+
+#include "STM32DataEEPROM.h"
+
+STM32DataEEPROM DataEEPROM;
+
+#ifdef ARDUINO
+// the data EEPROM is memory mapped for reading
+void STM32DataEEPROM::read(uint32_t offset, void *dest, uint32_t len) {
+  if (offset + len > DATA_EEPROM_SIZE) {
+    return;
+  }
+  memcpy(dest, (const void *)(DATA_EEPROM_BASE + offset), len);
+}
+
+/*
+  Programs a word or byte only when its content changes, every program
+  operation costs about 3 ms of run current and one erase cycle.
+*/
+bool STM32DataEEPROM::write(uint32_t offset, const void *src, uint32_t len) {
+  const uint8_t *data = (const uint8_t *)src;
+  uint32_t addr = DATA_EEPROM_BASE + offset;
+  bool ok = true;
+
+  if (offset + len > DATA_EEPROM_SIZE) {
+    return false;
+  }
+
+  HAL_FLASHEx_DATAEEPROM_Unlock();
+  while (len > 0) {
+    if (((addr & 3) == 0) && (len >= 4)) {
+      uint32_t word;
+      memcpy(&word, data, 4);
+      if (*(volatile uint32_t *)addr != word) {
+        ok &= (HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_WORD, addr,
+                                              word) == HAL_OK);
+      }
+      addr += 4;
+      data += 4;
+      len -= 4;
+    } else {
+      if (*(volatile uint8_t *)addr != *data) {
+        ok &= (HAL_FLASHEx_DATAEEPROM_Program(FLASH_TYPEPROGRAMDATA_BYTE, addr,
+                                              *data) == HAL_OK);
+      }
+      addr++;
+      data++;
+      len--;
+    }
+  }
+  HAL_FLASHEx_DATAEEPROM_Lock();
+  return ok;
+}
+#else
+#include <stdio.h>
+
+// a missing or short file reads as an erased EEPROM
+void STM32DataEEPROM::loadImage(uint8_t *image) {
+  memset(image, 0, DATA_EEPROM_SIZE);
+  FILE *f = fopen(_path, "rb");
+  if (f != NULL) {
+    fread(image, 1, DATA_EEPROM_SIZE, f);
+    fclose(f);
+  }
+}
+
+bool STM32DataEEPROM::saveImage(const uint8_t *image) {
+  FILE *f = fopen(_path, "wb");
+  if (f == NULL) {
+    return false;
+  }
+  bool ok = (fwrite(image, 1, DATA_EEPROM_SIZE, f) == DATA_EEPROM_SIZE);
+  return (fclose(f) == 0) && ok;
+}
+
+void STM32DataEEPROM::read(uint32_t offset, void *dest, uint32_t len) {
+  uint8_t image[DATA_EEPROM_SIZE];
+
+  if (offset + len > DATA_EEPROM_SIZE) {
+    return;
+  }
+  loadImage(image);
+  memcpy(dest, image + offset, len);
+}
+
+bool STM32DataEEPROM::write(uint32_t offset, const void *src, uint32_t len) {
+  uint8_t image[DATA_EEPROM_SIZE];
+
+  if (offset + len > DATA_EEPROM_SIZE) {
+    return false;
+  }
+  loadImage(image);
+  memcpy(image + offset, src, len);
+  return saveImage(image);
+}
+#endif
+
+// CRC-32 (IEEE 802.3 polynomial, no final inversion), pass the previous
+// result as crc to continue over several blocks
+uint32_t STM32DataEEPROM::crc32(const void *data, uint32_t len, uint32_t crc) {
+  const uint8_t *p = (const uint8_t *)data;
+  while (len--) {
+    crc ^= *p++;
+    for (uint8_t i = 0; i < 8; i++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+  }
+  return crc;
+}
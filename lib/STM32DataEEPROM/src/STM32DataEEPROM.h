@@ -0,0 +1,51 @@
+/*
+@file   STM32DataEEPROM.h
+@brief  Access to the STM32L0 data EEPROM (2 KB on the STM32L051). Host
+        builds keep the EEPROM in an image file instead.
+*/
+
+#ifndef _STM32_DATA_EEPROM_H_
+#define _STM32_DATA_EEPROM_H_
+
+#ifdef ARDUINO
+#include <Arduino.h>
+
+#define DATA_EEPROM_SIZE (DATA_EEPROM_END - DATA_EEPROM_BASE + 1)
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// host build: same size as the STM32L051, erased bytes read as 0
+#define DATA_EEPROM_SIZE 2048
+#define DATA_EEPROM_FILE "data_eeprom.bin"
+#endif
+
+class STM32DataEEPROM {
+
+public:
+  uint32_t size() { return DATA_EEPROM_SIZE; }
+  void read(uint32_t offset, void *dest, uint32_t len);
+  bool write(uint32_t offset, const void *src, uint32_t len);
+
+#ifndef ARDUINO
+  // image file used by the host build, the file can be flashed to the data
+  // EEPROM (0x08080000) as it is
+  void setFile(const char *path) { _path = path; }
+#endif
+
+  static uint32_t crc32(const void *data, uint32_t len,
+                        uint32_t crc = 0xFFFFFFFF);
+
+#ifndef ARDUINO
+private:
+  const char *_path = DATA_EEPROM_FILE;
+
+  void loadImage(uint8_t *image);
+  bool saveImage(const uint8_t *image);
+#endif
+};
+
+extern STM32DataEEPROM DataEEPROM;
+
+#endif // _STM32_DATA_EEPROM_H_
@@ -0,0 +1,168 @@
+/*
+@file   STM32DebugUart.cpp
+@brief  USART2 transmit through DMA1 channel 4 from a ring buffer
+*/
+
+#include "STM32DebugUart.h"
+#include "PeripheralPins.h"
+#include "pinmap.h"
+
+#define DEBUG_UART_TX PA2
+
+// DMA request 4 of channel 4 is USART2_TX (RM0377, table 51)
+#define DEBUG_UART_DMA_REQUEST 4
+
+#define MASK (DEBUG_UART_BUFFER_SIZE - 1)
+
+STM32DebugUart DebugUart;
+
+/*
+  The baud rate comes from PCLK1, so begin() runs again after a clock
+  change. By then the new clock already drives the old divider, bytes still
+  in the ring must be drained with flush() before the switch (a pre-change
+  callback of the clock manager). The wait here only keeps a transfer from
+  being cut off when begin() is called again without a clock change.
+*/
+void STM32DebugUart::begin(uint32_t baud) {
+  if (_baud != 0) {
+    waitIdle();
+  }
+  _baud = baud;
+
+  __HAL_RCC_USART2_CLK_ENABLE();
+  __HAL_RCC_DMA1_CLK_ENABLE();
+  pinmap_pinout(digitalPinToPinName(DEBUG_UART_TX), PinMap_UART_TX);
+
+  USART2->CR1 = 0;
+  USART2->BRR = (HAL_RCC_GetPCLK1Freq() + baud / 2) / baud;
+  USART2->CR3 = USART_CR3_DMAT;
+  USART2->CR1 = USART_CR1_TE | USART_CR1_UE;
+
+  DMA1_CSELR->CSELR = (DMA1_CSELR->CSELR & ~DMA_CSELR_C4S) |
+                      (DEBUG_UART_DMA_REQUEST << DMA_CSELR_C4S_Pos);
+  DMA1_Channel4->CCR = 0;
+  DMA1_Channel4->CPAR = (uint32_t)&USART2->TDR;
+
+  HAL_NVIC_SetPriority(DMA1_Channel4_5_6_7_IRQn, DEBUG_UART_IRQ_PRIO, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_5_6_7_IRQn);
+
+  // bytes written before begin() go out now
+  if (_inFlight == 0) {
+    startTransfer();
+  }
+}
+
+void STM32DebugUart::end() {
+  waitIdle();
+  HAL_NVIC_DisableIRQ(DMA1_Channel4_5_6_7_IRQn);
+  USART2->CR1 = 0;
+  __HAL_RCC_USART2_CLK_DISABLE();
+  _baud = 0;
+}
+
+int STM32DebugUart::availableForWrite() {
+  return DEBUG_UART_BUFFER_SIZE - 1 - ((_head - _tail) & MASK);
+}
+
+size_t STM32DebugUart::write(uint8_t c) { return write(&c, 1); }
+
+/*
+  Only the producer moves _head and only the interrupt moves _tail, the
+  free space seen here can only grow while copying. The transfer is started
+  here only when the DMA is idle, a running one picks the new bytes up from
+  its completion interrupt.
+*/
+size_t STM32DebugUart::write(const uint8_t *buffer, size_t size) {
+  uint16_t head = _head;
+  uint16_t room = DEBUG_UART_BUFFER_SIZE - 1 - ((head - _tail) & MASK);
+  size_t n = size;
+  if (n > room) {
+    n = room;
+    _dropped += size - room;
+    _overruns++;
+  }
+  for (size_t i = 0; i < n; i++) {
+    _buffer[head] = buffer[i];
+    head = (head + 1) & MASK;
+  }
+  _head = head;
+
+  uint16_t fill = (head - _tail) & MASK;
+  if (fill > _highWater) {
+    _highWater = fill;
+  }
+
+  if (_baud != 0 && _inFlight == 0) {
+    startTransfer();
+  }
+  // the dropped part counts as written, the caller must not retry it
+  return size;
+}
+
+// one contiguous block from _tail, the wrap-around goes in the next one
+void STM32DebugUart::startTransfer() {
+  __disable_irq();
+  uint16_t tail = _tail;
+  uint16_t head = _head;
+  if (_inFlight == 0 && head != tail) {
+    uint16_t n = (head > tail) ? head - tail : DEBUG_UART_BUFFER_SIZE - tail;
+    _inFlight = n;
+    DMA1_Channel4->CCR = 0;
+    DMA1_Channel4->CMAR = (uint32_t)&_buffer[tail];
+    DMA1_Channel4->CNDTR = n;
+    DMA1->IFCR = DMA_IFCR_CGIF4;
+    DMA1_Channel4->CCR = DMA_CCR_MINC | DMA_CCR_DIR | DMA_CCR_TCIE |
+                         DMA_CCR_TEIE | DMA_CCR_EN;
+  }
+  __enable_irq();
+}
+
+void STM32DebugUart::onTransferComplete() {
+  DMA1_Channel4->CCR = 0;
+  DMA1->IFCR = DMA_IFCR_CGIF4;
+  _tail = (_tail + _inFlight) & MASK;
+  _inFlight = 0;
+  startTransfer();
+}
+
+void STM32DebugUart::stopTransfer() {
+  __disable_irq();
+  DMA1_Channel4->CCR = 0;
+  DMA1->IFCR = DMA_IFCR_CGIF4;
+  uint16_t lost = (_head - _tail) & MASK;
+  _dropped += lost;
+  _tail = _head;
+  _inFlight = 0;
+  __enable_irq();
+}
+
+// the DMA has handed over the last byte when the ring is empty, the USART
+// then still shifts it out
+void STM32DebugUart::waitIdle() {
+  while (_tail != _head) {
+  }
+  while (!(USART2->ISR & USART_ISR_TC)) {
+  }
+}
+
+void STM32DebugUart::flush() {
+  if (_baud != 0) {
+    waitIdle();
+  }
+}
+
+void STM32DebugUart::prepareSleep() {
+  if (_baud == 0) {
+    return;
+  }
+  if (_policy == DEBUG_UART_DISCARD) {
+    stopTransfer();
+  }
+  waitIdle();
+}
+
+extern "C" void DMA1_Channel4_5_6_7_IRQHandler(void) {
+  if (DMA1->ISR & (DMA_ISR_TCIF4 | DMA_ISR_TEIF4)) {
+    DebugUart.onTransferComplete();
+  }
+}
@@ -0,0 +1,76 @@
+/*
+@file   STM32DebugUart.h
+@brief  Transmit only debug port on USART2 (TX on PA2). write() copies into
+        a ring buffer and returns, DMA1 channel 4 drains it in the
+        background. The ring is lock-free for one producer (the main loop)
+        and one consumer (the DMA interrupt).
+*/
+
+#ifndef _STM32_DEBUG_UART_H_
+#define _STM32_DEBUG_UART_H_
+
+#include <Arduino.h>
+
+// bytes waiting for the DMA, a power of 2
+#ifndef DEBUG_UART_BUFFER_SIZE
+#define DEBUG_UART_BUFFER_SIZE 256
+#endif
+
+// interrupt priority of the DMA channel
+#ifndef DEBUG_UART_IRQ_PRIO
+#define DEBUG_UART_IRQ_PRIO 3
+#endif
+
+// what prepareSleep() does with bytes that are not sent yet
+enum DebugUartSleepPolicy {
+  DEBUG_UART_WAIT,   // stay awake until the last stop bit is out
+  DEBUG_UART_DISCARD // drop them and count them as dropped
+};
+
+class STM32DebugUart : public Print {
+
+public:
+  void begin(uint32_t baud);
+  void end();
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  using Print::write;
+  int availableForWrite() override;
+
+  // waits until everything is on the line, also before a clock change
+  void flush() override;
+
+  // call before stop mode, the DMA and USART stop with the clocks
+  void setSleepPolicy(DebugUartSleepPolicy policy) { _policy = policy; }
+  void prepareSleep();
+
+  // bytes lost to a full ring or to DEBUG_UART_DISCARD
+  uint32_t getDropped() { return _dropped; }
+  // writes that found the ring full
+  uint32_t getOverruns() { return _overruns; }
+  // largest fill of the ring
+  uint16_t getHighWater() { return _highWater; }
+
+  // DMA transfer complete, from the interrupt handler
+  void onTransferComplete();
+
+private:
+  void startTransfer();
+  void stopTransfer();
+  void waitIdle();
+
+  uint8_t _buffer[DEBUG_UART_BUFFER_SIZE];
+  volatile uint16_t _head = 0;   // written by write()
+  volatile uint16_t _tail = 0;   // advanced by the interrupt
+  volatile uint16_t _inFlight = 0;
+  uint32_t _baud = 0;
+  DebugUartSleepPolicy _policy = DEBUG_UART_WAIT;
+  uint32_t _dropped = 0;
+  uint32_t _overruns = 0;
+  uint16_t _highWater = 0;
+};
+
+extern STM32DebugUart DebugUart;
+
+#endif // _STM32_DEBUG_UART_H_
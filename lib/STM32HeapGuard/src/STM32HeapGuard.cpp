@@ -0,0 +1,82 @@
+/*
+@file   STM32HeapGuard.cpp
+@brief  Allocation guard on the newlib reentrant allocator
+*/
+
+#include "STM32HeapGuard.h"
+#include <reent.h>
+
+STM32HeapGuard HeapGuard;
+
+static volatile bool Locked = false;
+static volatile uint32_t Allocations = 0;
+static volatile uint32_t Violations = 0;
+static volatile uint32_t LastCaller = 0;
+static uint8_t *HeapStart = nullptr;
+static uint32_t HighWater = 0;
+
+extern "C" {
+
+void *__real__malloc_r(struct _reent *r, size_t size);
+void *__real__sbrk_r(struct _reent *r, ptrdiff_t incr);
+
+/*
+  malloc(), calloc(), realloc() and new all end in _malloc_r. The return
+  address is the caller of malloc() or of the newlib wrapper around it,
+  enough to find the line in the map or with addr2line.
+*/
+void *__wrap__malloc_r(struct _reent *r, size_t size) {
+  Allocations++;
+  if (Locked) {
+    Violations++;
+    LastCaller = (uint32_t)__builtin_return_address(0);
+#ifdef HEAP_GUARD_TRAP
+    __BKPT(0);
+#endif
+  }
+  return __real__malloc_r(r, size);
+}
+
+// the heap only grows through sbrk, newlib-nano never gives memory back
+void *__wrap__sbrk_r(struct _reent *r, ptrdiff_t incr) {
+  uint8_t *prev = (uint8_t *)__real__sbrk_r(r, incr);
+  if (prev != (uint8_t *)-1) {
+    if (HeapStart == nullptr) {
+      HeapStart = prev;
+    }
+    uint32_t top = (uint32_t)(prev + incr - HeapStart);
+    if (top > HighWater) {
+      HighWater = top;
+    }
+  }
+  return prev;
+}
+}
+
+void STM32HeapGuard::lock() { Locked = true; }
+
+void STM32HeapGuard::unlock() { Locked = false; }
+
+bool STM32HeapGuard::isLocked() { return Locked; }
+
+uint32_t STM32HeapGuard::getAllocations() { return Allocations; }
+
+uint32_t STM32HeapGuard::getViolations() { return Violations; }
+
+uint32_t STM32HeapGuard::getLastCaller() { return LastCaller; }
+
+uint32_t STM32HeapGuard::getHighWater() { return HighWater; }
+
+void STM32HeapGuard::report(Print &out) {
+  out.print("[HEAP] allocations ");
+  out.print(Allocations);
+  out.print(" high-water ");
+  out.print(HighWater);
+  out.print(" after lock ");
+  out.print(Violations);
+  if (Violations > 0) {
+    out.print(" last from 0x");
+    out.print(LastCaller, HEX);
+  }
+  out.println();
+}
@@ -0,0 +1,36 @@
+/*
+@file   STM32HeapGuard.h
+@brief  Counts the heap allocations and flags every one made after lock(),
+        so a String or new that slips into the sample loop shows up in the
+        debug output. Also keeps the high-water mark of the heap.
+
+        Needs the linker to route newlib's allocator through this library:
+        -Wl,--wrap=_malloc_r -Wl,--wrap=_sbrk_r
+*/
+
+#ifndef _STM32_HEAP_GUARD_H_
+#define _STM32_HEAP_GUARD_H_
+
+#include <Arduino.h>
+
+class STM32HeapGuard {
+
+public:
+  // allocations from now on are violations, call at the end of setup()
+  void lock();
+  void unlock();
+  bool isLocked();
+
+  uint32_t getAllocations();
+  uint32_t getViolations();
+  // return address of the last allocation after lock()
+  uint32_t getLastCaller();
+  // bytes taken from the heap region by sbrk, never decreases
+  uint32_t getHighWater();
+
+  void report(Print &out);
+};
+
+extern STM32HeapGuard HeapGuard;
+
+#endif // _STM32_HEAP_GUARD_H_
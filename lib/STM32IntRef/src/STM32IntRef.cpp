@@ -50,3 +50,202 @@ int32_t STM32IntRef::readVoltage(int32_t VRef, uint32_t pin)
 {
   return (__LL_ADC_CALC_DATA_TO_VOLTAGE(VRef, analogRead(pin), LL_ADC_RESOLUTION));
 }
+
+#if defined(STM32L0xx)
+#include "PeripheralPins.h"
+#include "pinmap.h"
+
+/* ADC cycles x 2 of the SMP settings, RM0377 14.12.6 */
+static const uint16_t SampleCycles2[] = {3, 7, 15, 25, 39, 79, 159, 321};
+
+/* VREFINT and the temperature sensor need a sampling time of 10 us */
+#define INTREF_SAMPLE_TIME_US 10
+
+/* loop limit of the register waits */
+#define INTREF_TIMEOUT 100000
+
+static bool waitFor(volatile uint32_t *reg, uint32_t mask, uint32_t value)
+{
+  for (uint32_t i = 0; i < INTREF_TIMEOUT; i++) {
+    if ((*reg & mask) == value) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+  The ADC runs from PCLK/2, so it follows the clock profile without the HSI.
+  Below 3.5 MHz the low frequency mode is mandatory. The sampling time is the
+  shortest that still gives the internal channels 10 us, one setting covers
+  the whole scan. The calibration factor does not survive the regulator being
+  switched off, it is redone on every power up (about 83 ADC cycles).
+*/
+bool STM32IntRef::powerUp(uint16_t oversampling)
+{
+  __HAL_RCC_ADC1_CLK_ENABLE();
+  uint32_t adcClock = HAL_RCC_GetPCLK2Freq() / 2;
+
+  // the clock mode and calibration need the ADC disabled
+  if (READ_BIT(ADC1->CR, ADC_CR_ADEN)) {
+    SET_BIT(ADC1->CR, ADC_CR_ADDIS);
+    waitFor(&ADC1->CR, ADC_CR_ADEN, 0);
+  }
+
+  ADC1->CFGR2 = ADC_CFGR2_CKMODE_0;
+  if (adcClock < 3500000) {
+    SET_BIT(ADC->CCR, ADC_CCR_LFMEN);
+  } else {
+    CLEAR_BIT(ADC->CCR, ADC_CCR_LFMEN);
+  }
+
+  SET_BIT(ADC1->CR, ADC_CR_ADVREGEN);
+  delayMicroseconds(10);
+  SET_BIT(ADC1->CR, ADC_CR_ADCAL);
+  if (!waitFor(&ADC1->CR, ADC_CR_ADCAL, 0)) {
+    return false;
+  }
+  // ADEN must not be set within 4 ADC cycles after the calibration
+  delayMicroseconds((4000000 + adcClock - 1) / adcClock);
+
+  // ratio 2^(n+1), the shift keeps the result within 16 bits
+  uint8_t ratioBits = 0;
+  while ((1U << ratioBits) < oversampling && ratioBits < 8) {
+    ratioBits++;
+  }
+  uint8_t shift = ratioBits > 4 ? ratioBits - 4 : 0;
+  _resultBits = 12 + ratioBits - shift;
+  if (ratioBits > 0) {
+    ADC1->CFGR2 |= ((uint32_t)(ratioBits - 1) << ADC_CFGR2_OVSR_Pos) |
+                   ((uint32_t)shift << ADC_CFGR2_OVSS_Pos) | ADC_CFGR2_OVSE;
+  }
+
+  // 12 bit, right aligned, one scan per start, keep the newest on overrun
+  ADC1->CFGR1 = ADC_CFGR1_OVRMOD;
+
+  uint32_t needed2 =
+      (uint32_t)((uint64_t)adcClock * INTREF_SAMPLE_TIME_US * 2 / 1000000);
+  uint8_t smp = 0;
+  while (smp < 7 && SampleCycles2[smp] < needed2) {
+    smp++;
+  }
+  ADC1->SMPR = smp;
+
+  // the sensor needs 10 us, VREFINT a few ms when it was off in stop mode
+  SET_BIT(ADC->CCR, ADC_CCR_VREFEN | ADC_CCR_TSEN);
+  delayMicroseconds(10);
+  if (!waitFor(&PWR->CSR, PWR_CSR_VREFINTRDYF, PWR_CSR_VREFINTRDYF)) {
+    return false;
+  }
+
+  ADC1->ISR = ADC_ISR_ADRDY;
+  SET_BIT(ADC1->CR, ADC_CR_ADEN);
+  return waitFor(&ADC1->ISR, ADC_ISR_ADRDY, ADC_ISR_ADRDY);
+}
+
+void STM32IntRef::powerDown()
+{
+  if (READ_BIT(ADC1->CR, ADC_CR_ADSTART)) {
+    SET_BIT(ADC1->CR, ADC_CR_ADSTP);
+    waitFor(&ADC1->CR, ADC_CR_ADSTP, 0);
+  }
+  if (READ_BIT(ADC1->CR, ADC_CR_ADEN)) {
+    SET_BIT(ADC1->CR, ADC_CR_ADDIS);
+    waitFor(&ADC1->CR, ADC_CR_ADEN, 0);
+  }
+  CLEAR_BIT(ADC1->CR, ADC_CR_ADVREGEN);
+  CLEAR_BIT(ADC->CCR, ADC_CCR_VREFEN | ADC_CCR_TSEN | ADC_CCR_LFMEN);
+  __HAL_RCC_ADC1_CLK_DISABLE();
+}
+
+/**
+  * @brief  Convert VREFINT, the temperature sensor and up to INTREF_MAX_PINS
+  *         pins in one scan with the hardware oversampler, then switch the
+  *         ADC off. The scan runs in ascending channel order, the results
+  *         are sorted back to the order of pins.
+  * @param  result: supply, temperature and pin voltages
+  * @param  pins: Arduino pin numbers of the analog inputs, or nullptr
+  * @param  count: number of pins
+  * @param  oversampling: samples accumulated per result, 1 to 256
+  * @retval false when the ADC did not respond, result is then unchanged
+  */
+bool STM32IntRef::sample(IntRefSample &result, const uint32_t *pins,
+                         uint8_t count, uint16_t oversampling)
+{
+  if (count > INTREF_MAX_PINS) {
+    count = INTREF_MAX_PINS;
+  }
+
+  uint32_t chselr = (1UL << __LL_ADC_CHANNEL_TO_DECIMAL_NB(LL_ADC_CHANNEL_VREFINT)) |
+                    (1UL << __LL_ADC_CHANNEL_TO_DECIMAL_NB(LL_ADC_CHANNEL_TEMPSENSOR));
+  uint8_t channel[INTREF_MAX_PINS];
+  for (uint8_t i = 0; i < count; i++) {
+    PinName p = digitalPinToPinName(pins[i]);
+    channel[i] = STM_PIN_CHANNEL(pinmap_function(p, PinMap_ADC));
+    pinmap_pinout(p, PinMap_ADC);
+    chselr |= 1UL << channel[i];
+  }
+
+  uint16_t raw[19];
+  bool ok = powerUp(oversampling);
+  if (ok) {
+    ADC1->CHSELR = chselr;
+    ADC1->ISR = ADC_ISR_EOC | ADC_ISR_EOS | ADC_ISR_OVR;
+    SET_BIT(ADC1->CR, ADC_CR_ADSTART);
+    for (uint8_t ch = 0; ok && ch < 19; ch++) {
+      if (chselr & (1UL << ch)) {
+        ok = waitFor(&ADC1->ISR, ADC_ISR_EOC, ADC_ISR_EOC);
+        raw[ch] = ADC1->DR;
+      }
+    }
+  }
+  powerDown();
+  if (!ok) {
+    return false;
+  }
+
+  // calibration values are 12 bit at 3.0 V
+  uint8_t extra = _resultBits - 12;
+  uint32_t fullScale = (1UL << _resultBits) - 1;
+  uint32_t vref = raw[__LL_ADC_CHANNEL_TO_DECIMAL_NB(LL_ADC_CHANNEL_VREFINT)];
+  uint32_t ts = raw[__LL_ADC_CHANNEL_TO_DECIMAL_NB(LL_ADC_CHANNEL_TEMPSENSOR)];
+  int32_t vdda = ((uint32_t)VREFINT_CAL_VREF * ((uint32_t)*VREFINT_CAL_ADDR << extra)) / vref;
+  int32_t cal1 = (int32_t)*TEMPSENSOR_CAL1_ADDR << extra;
+  int32_t cal2 = (int32_t)*TEMPSENSOR_CAL2_ADDR << extra;
+  int32_t tsAtCal = (int32_t)(ts * (uint32_t)vdda / TEMPSENSOR_CAL_VREFANALOG);
+
+  result.vdda_mV = vdda;
+  result.temperature_cC =
+      (tsAtCal - cal1) * ((TEMPSENSOR_CAL2_TEMP - TEMPSENSOR_CAL1_TEMP) * 100) /
+          (cal2 - cal1) + TEMPSENSOR_CAL1_TEMP * 100;
+  for (uint8_t i = 0; i < count; i++) {
+    result.pin_mV[i] = raw[channel[i]] * (uint32_t)vdda / fullScale;
+  }
+  result.pinCount = count;
+  return true;
+}
+
+#else
+
+/* other series: the same result from single analogRead() conversions */
+bool STM32IntRef::sample(IntRefSample &result, const uint32_t *pins,
+                         uint8_t count, uint16_t oversampling)
+{
+  (void)oversampling;
+  if (count > INTREF_MAX_PINS) {
+    count = INTREF_MAX_PINS;
+  }
+  result.vdda_mV = readVref();
+#ifdef ATEMP
+  result.temperature_cC = readTempSensor(result.vdda_mV) * 100;
+#else
+  result.temperature_cC = 0;
+#endif
+  for (uint8_t i = 0; i < count; i++) {
+    result.pin_mV[i] = readVoltage(result.vdda_mV, pins[i]);
+  }
+  result.pinCount = count;
+  return true;
+}
+
+#endif
@@ -28,13 +28,36 @@
 #define ADC_RANGE 4096
 #endif
 
+/* Hardware oversampling of sample(), a power of 2 from 1 to 256 */
+#ifndef INTREF_OVERSAMPLING
+#define INTREF_OVERSAMPLING 16
+#endif
+
+/* Analog pins converted in the same scan as VREFINT and the sensor */
+#define INTREF_MAX_PINS 4
+
+/* Result of one sample() scan */
+struct IntRefSample {
+  int32_t vdda_mV;                  // supply from VREFINT and its calibration
+  int32_t temperature_cC;           // 0.01 degC, from the two point calibration
+  int32_t pin_mV[INTREF_MAX_PINS];  // in the order the pins were given
+  uint8_t pinCount;
+};
+
 class STM32IntRef {
   public:
     STM32IntRef();
     int32_t readVref();
     int32_t readTempSensor(int32_t VRef);
     int32_t readVoltage(int32_t VRef, uint32_t pin);
+    bool sample(IntRefSample &result, const uint32_t *pins = nullptr,
+                uint8_t count = 0, uint16_t oversampling = INTREF_OVERSAMPLING);
   private:
+#if defined(STM32L0xx)
+    bool powerUp(uint16_t oversampling);
+    void powerDown();
+    uint8_t _resultBits;
+#endif
 };
 
 // create IntRef object
@@ -35,6 +35,7 @@
 */
 
 #include "STM32LowPower.h"
+#include "STM32PowerHooks.h"
 
 STM32LowPower LowPower;
 
@@ -68,7 +69,9 @@ void STM32LowPower::idle(uint32_t ms)
   if ((ms != 0) || _rtc_wakeup) {
     programRtcWakeUp(ms, IDLE_MODE);
   }
+  PowerHooks.suspend(IDLE_MODE);
   LowPower_sleep(PWR_MAINREGULATOR_ON);
+  PowerHooks.resume(IDLE_MODE);
 }
 
 /**
@@ -82,7 +85,9 @@ void STM32LowPower::sleep(uint32_t ms)
   if ((ms != 0) || _rtc_wakeup) {
     programRtcWakeUp(ms, SLEEP_MODE);
   }
+  PowerHooks.suspend(SLEEP_MODE);
   LowPower_sleep(PWR_LOWPOWERREGULATOR_ON);
+  PowerHooks.resume(SLEEP_MODE);
 }
 
 /**
@@ -96,7 +101,11 @@ void STM32LowPower::deepSleep(uint32_t ms)
   if ((ms != 0) || _rtc_wakeup) {
     programRtcWakeUp(ms, DEEP_SLEEP_MODE);
   }
+  PowerHooks.suspend(DEEP_SLEEP_MODE);
   LowPower_stop(_serial);
+  // the shadow registers still hold the time of the stop entry
+  RTC_ResyncShadow();
+  PowerHooks.resume(DEEP_SLEEP_MODE);
 }
 
 /**
@@ -110,6 +119,7 @@ void STM32LowPower::shutdown(uint32_t ms)
   if ((ms != 0) || _rtc_wakeup) {
     programRtcWakeUp(ms, SHUTDOWN_MODE);
   }
+  PowerHooks.suspend(SHUTDOWN_MODE);
   LowPower_shutdown();
 }
 
@@ -168,18 +178,42 @@ void STM32LowPower::enableWakeupFrom(STM32RTC *rtc, voidFuncPtr callback, void *
   rtc->attachInterrupt(callback, data);
 }
 
+#if defined(ONESECOND_IRQn) && defined(RTC_CR_WUTE)
 /**
-  * @brief  Configure the RTC alarm
-  * @param  ms: time of the alarm in milliseconds.
+  * @brief  Start the RTC wakeup timer in periodic mode. The timer reloads in
+  *         hardware, so the low power calls skip the per sleep epoch and
+  *         alarm programming.
+  * @param  ms: wakeup period in milliseconds.
   * @param  lp_mode: low power mode targeted.
-  * @retval None
+  * @retval false if the period is out of range
   */
-void STM32LowPower::programRtcWakeUp(uint32_t ms, LP_Mode lp_mode)
+bool STM32LowPower::setPeriodicWakeup(uint32_t ms, LP_Mode lp_mode)
 {
-  uint32_t epoc;
-  uint32_t sec;
   STM32RTC &rtc = STM32RTC::getInstance();
-  STM32RTC::Source_Clock clkSrc = rtc.getClockSource();
+
+  rtc.configForLowPower(lowPowerClockSource(lp_mode));
+  return rtc.startWakeUpTimer(ms);
+}
+
+/**
+  * @brief  Stop the periodic RTC wakeup.
+  * @param  None
+  * @retval None
+  */
+void STM32LowPower::clearPeriodicWakeup(void)
+{
+  STM32RTC::getInstance().stopWakeUpTimer();
+}
+#endif
+
+/**
+  * @brief  RTC clock source able to wake up the device from a low power mode
+  * @param  lp_mode: low power mode targeted.
+  * @retval clock source
+  */
+STM32RTC::Source_Clock STM32LowPower::lowPowerClockSource(LP_Mode lp_mode)
+{
+  STM32RTC::Source_Clock clkSrc = STM32RTC::getInstance().getClockSource();
 
   switch (lp_mode) {
     case IDLE_MODE:
@@ -200,7 +234,22 @@ void STM32LowPower::programRtcWakeUp(uint32_t ms, LP_Mode lp_mode)
 #endif
       break;
   }
-  rtc.configForLowPower(clkSrc);
+  return clkSrc;
+}
+
+/**
+  * @brief  Configure the RTC alarm
+  * @param  ms: time of the alarm in milliseconds.
+  * @param  lp_mode: low power mode targeted.
+  * @retval None
+  */
+void STM32LowPower::programRtcWakeUp(uint32_t ms, LP_Mode lp_mode)
+{
+  uint32_t epoc;
+  uint32_t sec;
+  STM32RTC &rtc = STM32RTC::getInstance();
+
+  rtc.configForLowPower(lowPowerClockSource(lp_mode));
 
   if (ms != 0) {
     // Convert millisecond to second
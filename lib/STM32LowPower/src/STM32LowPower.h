@@ -85,11 +85,36 @@ public:
   void enableWakeupFrom(HardwareSerial *serial, voidFuncPtrVoid callback);
   void enableWakeupFrom(STM32RTC *rtc, voidFuncPtr callback, void *data = NULL);
 
+  // stabilization delay after a wakeup from deepSleep, none by default
+  void setWakeupDelay(lowPowerWakeUpSource_t source, uint32_t ms)
+  {
+    LowPower_SetWakeUpDelay(source, ms);
+  }
+  // WFI exit to application in us, measured with USE_WAKEUP_LATENCY
+  uint32_t getWakeupLatency(bool max = false)
+  {
+    return LowPower_GetWakeUpLatency(max);
+  }
+
+  // this boot is a wakeup from shutdown() (standby on the L0)
+  bool resumedFromStandby(void)
+  {
+    return LowPower_ResumedFromStandby();
+  }
+
+#if defined(ONESECOND_IRQn) && defined(RTC_CR_WUTE)
+  // wake up every ms from the RTC wakeup timer, programmed once. Use
+  // idle(), sleep() or deepSleep() without a delay afterwards.
+  bool setPeriodicWakeup(uint32_t ms, LP_Mode lp_mode = DEEP_SLEEP_MODE);
+  void clearPeriodicWakeup(void);
+#endif
+
 private:
   bool _configured;  // Low Power mode initialization status
   serial_t *_serial; // Serial for wakeup from deep sleep
   bool _rtc_wakeup;  // Is RTC wakeup?
   void programRtcWakeUp(uint32_t ms, LP_Mode lp_mode);
+  STM32RTC::Source_Clock lowPowerClockSource(LP_Mode lp_mode);
 };
 
 extern STM32LowPower LowPower;
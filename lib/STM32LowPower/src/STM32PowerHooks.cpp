@@ -0,0 +1,136 @@
+/*
+@file   STM32PowerHooks.cpp
+@brief  Suspend and resume hooks around the low power modes
+*/
+
+#include "STM32PowerHooks.h"
+
+STM32PowerHooks PowerHooks;
+
+// one bit per pin to the two bit MODER/PUPDR field mask
+static uint32_t fieldMask(uint16_t pins) {
+  uint32_t mask = 0;
+  for (uint8_t i = 0; i < 16; i++) {
+    if (pins & (1U << i)) {
+      mask |= 3UL << (2 * i);
+    }
+  }
+  return mask;
+}
+
+int8_t STM32PowerHooks::add(const char *name, powerHookCallback suspend,
+                            powerHookCallback resume, LP_Mode min_mode) {
+  if (_count >= POWER_HOOKS_MAX) {
+    return -1;
+  }
+  Hook &hook = _hooks[_count];
+  hook.name = name;
+  hook.suspend = suspend;
+  hook.resume = resume;
+  hook.min_mode = min_mode;
+  for (uint8_t p = 0; p < POWER_HOOK_PORTS; p++) {
+    hook.pins[p] = 0;
+  }
+  hook.runs = 0;
+  hook.time_us = 0;
+  return _count++;
+}
+
+bool STM32PowerHooks::addPin(int8_t hook, uint32_t pin) {
+  PinName pn = digitalPinToPinName(pin);
+  if ((hook < 0) || (hook >= _count) || (pn == NC) ||
+      (STM_PORT(pn) >= POWER_HOOK_PORTS)) {
+    return false;
+  }
+  _hooks[hook].pins[STM_PORT(pn)] |= STM_GPIO_PIN(pn);
+  return true;
+}
+
+/*
+  Hooks run in registration order, then their pins go to analog mode
+  without pull, which is the lowest leakage state of an STM32 pin.
+*/
+void STM32PowerHooks::suspend(LP_Mode mode) {
+  for (uint8_t p = 0; p < POWER_HOOK_PORTS; p++) {
+    _analog[p] = 0;
+  }
+
+  for (uint8_t i = 0; i < _count; i++) {
+    Hook &hook = _hooks[i];
+    if (mode < hook.min_mode) {
+      continue;
+    }
+    if (hook.suspend != nullptr) {
+      uint32_t start = micros();
+      hook.suspend(mode);
+      hook.time_us += micros() - start;
+    }
+    hook.runs++;
+    for (uint8_t p = 0; p < POWER_HOOK_PORTS; p++) {
+      _analog[p] |= hook.pins[p];
+    }
+  }
+
+  for (uint8_t p = 0; p < POWER_HOOK_PORTS; p++) {
+    if (_analog[p] == 0) {
+      continue;
+    }
+    GPIO_TypeDef *gpio = get_GPIO_Port(p);
+    uint32_t mask = fieldMask(_analog[p]);
+    _moder[p] = gpio->MODER;
+    _pupdr[p] = gpio->PUPDR;
+    gpio->PUPDR &= ~mask;
+    gpio->MODER |= mask;
+  }
+}
+
+// the pins come back first, then the hooks in reverse order
+void STM32PowerHooks::resume(LP_Mode mode) {
+  for (uint8_t p = 0; p < POWER_HOOK_PORTS; p++) {
+    if (_analog[p] == 0) {
+      continue;
+    }
+    GPIO_TypeDef *gpio = get_GPIO_Port(p);
+    uint32_t mask = fieldMask(_analog[p]);
+    gpio->MODER = (gpio->MODER & ~mask) | (_moder[p] & mask);
+    gpio->PUPDR = (gpio->PUPDR & ~mask) | (_pupdr[p] & mask);
+    _analog[p] = 0;
+  }
+
+  for (uint8_t i = _count; i > 0; i--) {
+    Hook &hook = _hooks[i - 1];
+    if ((mode < hook.min_mode) || (hook.resume == nullptr)) {
+      continue;
+    }
+    uint32_t start = micros();
+    hook.resume(mode);
+    hook.time_us += micros() - start;
+  }
+}
+
+uint32_t STM32PowerHooks::getRuns(int8_t hook) {
+  return ((hook >= 0) && (hook < _count)) ? _hooks[hook].runs : 0;
+}
+
+// suspend plus resume time, SysTick based
+uint32_t STM32PowerHooks::getTime_us(int8_t hook) {
+  return ((hook >= 0) && (hook < _count)) ? _hooks[hook].time_us : 0;
+}
+
+void STM32PowerHooks::resetStats() {
+  for (uint8_t i = 0; i < _count; i++) {
+    _hooks[i].runs = 0;
+    _hooks[i].time_us = 0;
+  }
+}
+
+void STM32PowerHooks::report(Print &out) {
+  for (uint8_t i = 0; i < _count; i++) {
+    out.print("[POWER] hook ");
+    out.print(_hooks[i].name);
+    out.print(" runs ");
+    out.print(_hooks[i].runs);
+    out.print(" us ");
+    out.println(_hooks[i].time_us);
+  }
+}
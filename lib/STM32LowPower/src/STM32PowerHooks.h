@@ -0,0 +1,62 @@
+/*
+@file   STM32PowerHooks.h
+@brief  Suspend and resume hooks run by STM32LowPower around every low power
+        entry. A hook can own pins, they are switched to analog for the
+        sleep and restored afterwards. Every hook counts its runs and the
+        time spent in it.
+*/
+
+#ifndef _STM32_POWER_HOOKS_H_
+#define _STM32_POWER_HOOKS_H_
+
+#include <Arduino.h>
+#include "STM32LowPower.h"
+
+#define POWER_HOOKS_MAX 6
+
+// GPIOA to GPIOC
+#define POWER_HOOK_PORTS 3
+
+typedef void (*powerHookCallback)(LP_Mode mode);
+
+class STM32PowerHooks {
+
+public:
+  // runs for min_mode and deeper modes, returns the hook or -1
+  int8_t add(const char *name, powerHookCallback suspend,
+             powerHookCallback resume = nullptr,
+             LP_Mode min_mode = SLEEP_MODE);
+  bool addPin(int8_t hook, uint32_t pin);
+
+  // called by STM32LowPower
+  void suspend(LP_Mode mode);
+  void resume(LP_Mode mode);
+
+  uint32_t getRuns(int8_t hook);
+  uint32_t getTime_us(int8_t hook);
+  void resetStats();
+  void report(Print &out);
+
+private:
+  struct Hook {
+    const char *name;
+    powerHookCallback suspend;
+    powerHookCallback resume;
+    LP_Mode min_mode;
+    uint16_t pins[POWER_HOOK_PORTS];
+    uint32_t runs;
+    uint32_t time_us;
+  };
+
+  Hook _hooks[POWER_HOOKS_MAX];
+  uint8_t _count = 0;
+
+  // pins switched to analog by the current suspend and their saved state
+  uint16_t _analog[POWER_HOOK_PORTS];
+  uint32_t _moder[POWER_HOOK_PORTS];
+  uint32_t _pupdr[POWER_HOOK_PORTS];
+};
+
+extern STM32PowerHooks PowerHooks;
+
+#endif // _STM32_POWER_HOOKS_H_
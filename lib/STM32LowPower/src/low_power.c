@@ -41,6 +41,19 @@ static UART_HandleTypeDef *WakeUpUart = NULL;
 /* Save callback pointer */
 static void (*WakeUpUartCb)(void) = NULL;
 
+/* Standby flag of this boot, LowPower_init() clears it in the PWR */
+static bool ResumedFromStandby = false;
+
+/* Opt-in stabilization delay in ms after a wakeup from stop, per source */
+static uint32_t WakeUpDelay[LOWPOWER_WAKEUP_SOURCES] = {0};
+
+#if defined(USE_WAKEUP_LATENCY) && defined(LPTIM1) && defined(RCC_LPTIM1CLKSOURCE_LSI)
+/* LPTIM1 counts the LSI also in stop mode, it times the wakeup path */
+#define WAKEUP_LATENCY_TIMER
+static uint32_t WakeUpLatency = 0;
+static uint32_t WakeUpLatencyMax = 0;
+#endif
+
 #if defined(PWR_FLAG_WUF)
 #define PWR_FLAG_WU PWR_FLAG_WUF
 #elif defined(PWR_WAKEUP_ALL_FLAG)
@@ -70,12 +83,106 @@ void LowPower_init()
 #endif
   /* Check if the system was resumed from StandBy mode */
   if (__HAL_PWR_GET_FLAG(PWR_FLAG_SB) != RESET) {
+    ResumedFromStandby = true;
     /* Clear Standby flag */
     __HAL_PWR_CLEAR_FLAG(PWR_FLAG_SB);
   }
 
   /* Clear all related wakeup flags */
   __HAL_PWR_CLEAR_FLAG(PWR_FLAG_WU);
+
+#if defined(WAKEUP_LATENCY_TIMER)
+  /* Free running LPTIM1 on the LSI, only read on the wakeup path */
+  __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSI);
+  __HAL_RCC_LPTIM1_CLK_ENABLE();
+  LPTIM1->CR = LPTIM_CR_ENABLE;
+  LPTIM1->ARR = 0xFFFF;
+  while ((LPTIM1->ISR & LPTIM_ISR_ARROK) == 0);
+  LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+  LPTIM1->CR = LPTIM_CR_ENABLE | LPTIM_CR_CNTSTRT;
+#endif
+}
+
+#if defined(WAKEUP_LATENCY_TIMER)
+/* The counter runs asynchronous to the bus clock, two equal reads are valid */
+static uint32_t LowPower_LatencyCount(void)
+{
+  uint32_t count;
+  do {
+    count = LPTIM1->CNT;
+  } while (count != LPTIM1->CNT);
+  return count;
+}
+#endif
+
+/**
+  * @brief  Check if this boot is a wakeup from standby. Valid before and
+  *         after LowPower_init().
+  * @param  None
+  * @retval true after a standby wakeup
+  */
+bool LowPower_ResumedFromStandby(void)
+{
+#if defined(PWR_FLAG_SB)
+  return ResumedFromStandby || (__HAL_PWR_GET_FLAG(PWR_FLAG_SB) != RESET);
+#else
+  return ResumedFromStandby;
+#endif
+}
+
+/**
+  * @brief  Stabilization delay after a wakeup from stop mode. The clocks are
+  *         ready when SystemClock_ConfigFromStop() returns, a delay is only
+  *         needed by some peripherals of a wakeup source.
+  * @param  source: wakeup source
+  * @param  ms: delay in milliseconds, 0 (default) for none
+  * @retval None
+  */
+void LowPower_SetWakeUpDelay(lowPowerWakeUpSource_t source, uint32_t ms)
+{
+  if (source < LOWPOWER_WAKEUP_SOURCES) {
+    WakeUpDelay[source] = ms;
+  }
+}
+
+/**
+  * @brief  Time from the WFI exit to the return to the application of the
+  *         last wakeup from stop mode. Needs USE_WAKEUP_LATENCY.
+  * @param  max: return the largest latency since startup instead
+  * @retval latency in microseconds, LSI resolution
+  */
+uint32_t LowPower_GetWakeUpLatency(bool max)
+{
+#if defined(WAKEUP_LATENCY_TIMER)
+  return (uint32_t)(((uint64_t)(max ? WakeUpLatencyMax : WakeUpLatency) * 1000000U) / LSI_VALUE);
+#else
+  UNUSED(max);
+  return 0;
+#endif
+}
+
+/* Delay of the source that woke the MCU, the EXTI line is still pending */
+static uint32_t LowPower_WakeUpDelay(void)
+{
+#if defined(STM32L0xx) || defined(STM32F0xx)
+  /* EXTI line 17: RTC alarm, line 20: RTC wakeup timer */
+  uint32_t pending = EXTI->PR;
+  if (pending & ((1UL << 17) | (1UL << 20))) {
+    return WakeUpDelay[LOWPOWER_WAKEUP_RTC];
+  }
+  if (pending & 0xFFFFUL) {
+    return WakeUpDelay[LOWPOWER_WAKEUP_PIN];
+  }
+  return WakeUpDelay[LOWPOWER_WAKEUP_OTHER];
+#else
+  uint32_t delay = 0;
+  for (uint8_t i = 0; i < LOWPOWER_WAKEUP_SOURCES; i++) {
+    if (WakeUpDelay[i] > delay) {
+      delay = WakeUpDelay[i];
+    }
+  }
+  return delay;
+#endif
 }
 
 /**
@@ -478,9 +585,19 @@ void LowPower_stop(serial_t *obj)
   {
     HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
   }
+#if defined(WAKEUP_LATENCY_TIMER)
+  uint32_t wakeUpStart = LowPower_LatencyCount();
+#endif
 
   /* Exit Stop mode reset clocks */
   SystemClock_ConfigFromStop();
+#if defined(RCC_CFGR_SWS_Pos)
+  /* The oscillators are ready on return, poll the system clock switch
+     instead of waiting a fixed time */
+  while (((RCC->CFGR & RCC_CFGR_SWS) >> RCC_CFGR_SWS_Pos) !=
+         ((RCC->CFGR & RCC_CFGR_SW) >> RCC_CFGR_SW_Pos));
+#endif
+  uint32_t wakeUpDelay = LowPower_WakeUpDelay();
 #if defined(UART_WKUP_SUPPORT)
   if (WakeUpUart != NULL) {
     /* In case of WakeUp from UART, reset its clock source to HSI */
@@ -492,7 +609,15 @@ void LowPower_stop(serial_t *obj)
 #endif
   __enable_irq();
 
-  HAL_Delay(10);
+  if (wakeUpDelay != 0) {
+    HAL_Delay(wakeUpDelay);
+  }
+#if defined(WAKEUP_LATENCY_TIMER)
+  WakeUpLatency = (LowPower_LatencyCount() - wakeUpStart) & 0xFFFF;
+  if (WakeUpLatency > WakeUpLatencyMax) {
+    WakeUpLatencyMax = WakeUpLatency;
+  }
+#endif
 
   if (WakeUpUartCb != NULL) {
     WakeUpUartCb();
@@ -38,6 +38,7 @@
 #define __LOW_POWER_H
 
 /* Includes ------------------------------------------------------------------*/
+#include <stdbool.h>
 #include "stm32_def.h"
 #include "uart.h"
 
@@ -49,6 +50,14 @@ extern "C" {
 #endif
 
 /* Exported types ------------------------------------------------------------*/
+/* Wakeup sources with their own stabilization delay */
+typedef enum {
+  LOWPOWER_WAKEUP_RTC,
+  LOWPOWER_WAKEUP_PIN,
+  LOWPOWER_WAKEUP_OTHER, /* UART and the other EXTI lines */
+  LOWPOWER_WAKEUP_SOURCES
+} lowPowerWakeUpSource_t;
+
 /* Exported constants --------------------------------------------------------*/
 /* Exported macro ------------------------------------------------------------*/
 /* Exported functions ------------------------------------------------------- */
@@ -60,6 +69,9 @@ void LowPower_sleep(uint32_t regulator);
 void LowPower_stop(serial_t *obj);
 void LowPower_standby();
 void LowPower_shutdown();
+void LowPower_SetWakeUpDelay(lowPowerWakeUpSource_t source, uint32_t ms);
+uint32_t LowPower_GetWakeUpLatency(bool max);
+bool LowPower_ResumedFromStandby(void);
 /* Weaked function */
 void SystemClock_ConfigFromStop(void);
 #ifdef __cplusplus
@@ -0,0 +1,58 @@
+/*
+@file   LsiCapture.h
+@brief  Arithmetic of the TIM21 LSI measurement in calibrateLSI(). No HAL
+        access, so it also builds in the host tests.
+*/
+
+#ifndef _LSI_CAPTURE_H_
+#define _LSI_CAPTURE_H_
+
+#include <stdint.h>
+
+// TIM21 input capture prescaler, one capture every 8 LSI periods
+#define LSI_CAL_IC_DIV 8
+
+/*
+  Sums the differences of successive captures of the free running 16-bit
+  counter. The difference is taken in 16 bits, so a wrap between two
+  captures is counted correctly as long as they are less than 65536 timer
+  clocks apart.
+*/
+struct LsiCapture {
+  uint32_t ticks = 0;
+  uint16_t intervals = 0;
+
+  void add(uint16_t capture) {
+    if (_started) {
+      ticks += (uint16_t)(capture - _last);
+      intervals++;
+    }
+    _last = capture;
+    _started = true;
+  }
+
+private:
+  uint16_t _last = 0;
+  bool _started = false;
+};
+
+// TIM21 clock, twice PCLK2 when APB2 is divided (RM0377, 7.2.7)
+static inline uint32_t lsiTimerClock(uint32_t pclk2, bool apb2Divided) {
+  return apb2Divided ? pclk2 * 2 : pclk2;
+}
+
+/*
+  Measured LSI frequency over lsi_hz in 16.16 fixed point, from periods LSI
+  periods taking ticks timer clocks. 1.0 when nothing was measured.
+*/
+static inline uint32_t lsiCorrectionQ16(uint32_t periods, uint32_t ticks,
+                                        uint32_t timer_hz, uint32_t lsi_hz) {
+  if (ticks == 0) {
+    return 1UL << 16;
+  }
+  return (uint32_t)((((uint64_t)periods * timer_hz << 16) +
+                     (uint64_t)ticks * lsi_hz / 2) /
+                    ((uint64_t)ticks * lsi_hz));
+}
+
+#endif // _LSI_CAPTURE_H_
@@ -6,22 +6,51 @@ no crystal
 */
 
 #include "STM32LowPowerCal.h"
+#include "LsiCapture.h"
 #include "STM32LowPower.h"
 
+// SysTick time of calibrateRTC(), the calibration time is given against it
+#define RTC_CAL_DELAY 8000
+
+// longest wait for one capture in ms, the LSI is at least 26 kHz
+#define LSI_CAL_TIMEOUT 5
+
+// smooth calibration range of the RTC, 511 / 2^20 minus a margin
+#define SMOOTH_CAL_RANGE_PPB 487000
+#define PPB 1000000000LL
+
 // correction times for time used by powerdown and wakeup.
 void STM32LowPowerCal::deepSleep(uint32_t ms, int correction_Time) {
+  // the RTC itself runs at the right rate, only the overhead is left
+  if (LowPowerCal.rtc_Hardware_Calibrated) {
+    LowPower.deepSleep((ms > (uint32_t)correction_Time)
+                           ? ms - correction_Time
+                           : 0);
+    return;
+  }
   int correction_time =
-      round((float)ms * LowPowerCal.rtc_Time_Correction_Factor) -
+      (int)(((uint64_t)ms * LowPowerCal.rtc_Time_Correction_Q16 + 0x8000) >>
+            16) -
       correction_Time;
   // call superclass instance deepsleep methode
   LowPower.deepSleep(correction_time);
 }
 
-float STM32LowPowerCal::getRTCTimeCorrection() {
-  return rtc_Time_Correction_Factor;
+// deviation of the correction factor from 1 in ppm
+int32_t STM32LowPowerCal::getRTCTimeCorrection_ppm() {
+  return (int32_t)(((int64_t)rtc_Time_Correction_Q16 - 65536) * 1000000 /
+                   65536);
+}
+
+uint32_t STM32LowPowerCal::getRTCTimeCorrectionQ16() {
+  return rtc_Time_Correction_Q16;
 }
 
-void STM32LowPowerCal::setRTCCalibrationTime(float calibration_Time) {
+void STM32LowPowerCal::setRTCTimeCorrectionQ16(uint32_t correction) {
+  rtc_Time_Correction_Q16 = correction;
+}
+
+void STM32LowPowerCal::setRTCCalibrationTime(uint32_t calibration_Time) {
   LowPowerCal.rct_Calibration_Time = calibration_Time;
 }
 
@@ -30,13 +59,181 @@ void STM32LowPowerCal::calibrateRTC() {
   STM32RTC &rtc = STM32RTC::getInstance();
   // intiate rtc timer
   rtc.begin();
+#if defined(RTC_CALR_CALP)
+  // measure the uncalibrated LSI, a calibration survives a reset
+  int8_t predivA;
+  int16_t predivS;
+  rtc.setPrediv(-1, -1);
+  rtc.getPrediv(&predivA, &predivS);
+  rtc.setCalibration(predivA, predivS, false, 0);
+  rtc_Hardware_Calibrated = false;
+#endif
   rtc.setTime(16, 0, 0);
   // delay 8 seconds using systick timer (HSI clock)
-  delay(8000);
-  // get time from RTC (LSI clock)
-  int rtctime = rtc.getSeconds() * 1000 + rtc.getSubSeconds();
+  delay(RTC_CAL_DELAY);
+  // get time from RTC (LSI clock), seconds and subseconds from one read
+  STM32RTC::Snapshot now = rtc.getSnapshot();
+  uint32_t rtctime = now.seconds * 1000 + now.subSeconds;
   // calculate time correction factor
-  rtc_Time_Correction_Factor = (float)rtctime / (float)rct_Calibration_Time;
+  if (rct_Calibration_Time > 0) {
+    rtc_Time_Correction_Q16 =
+        (((uint64_t)rtctime << 16) + rct_Calibration_Time / 2) /
+        rct_Calibration_Time;
+  }
+}
+
+/*
+  Correction factor of a measurement of periods LSI periods taking ticks
+  timer clocks. The RTC prescalers assume LSI_VALUE, so the factor is the
+  measured LSI frequency over LSI_VALUE.
+*/
+uint32_t STM32LowPowerCal::lsiCorrectionQ16(uint32_t periods, uint32_t ticks,
+                                            uint32_t timer_hz) {
+  return ::lsiCorrectionQ16(periods, ticks, timer_hz, LSI_VALUE);
+}
+
+/*
+  TIM21 channel 1 is remapped to the LSI and captures every 8th rising edge
+  of it on the free running counter, the sum of the capture differences is
+  the length of periods LSI periods in timer clocks. The system clock is
+  derived from the HSI like SysTick in calibrateRTC(), the calibration time
+  scales the result the same way. Needs a system clock of 2 MHz or more.
+*/
+bool STM32LowPowerCal::calibrateLSI(uint16_t periods) {
+#if defined(TIM21) && defined(TIM21_OR_TI1_RMP)
+  uint16_t captures = periods / LSI_CAL_IC_DIV;
+  if (captures == 0) {
+    return false;
+  }
+
+  __HAL_RCC_LSI_ENABLE();
+  while (__HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY) == RESET) {
+  }
+
+  __HAL_RCC_TIM21_CLK_ENABLE();
+  TIM21->CR1 = 0;
+  TIM21->PSC = 0;
+  TIM21->ARR = 0xFFFF;
+  TIM21->OR = (TIM21->OR & ~TIM21_OR_TI1_RMP) | TIM21_OR_TI1_RMP_2 |
+              TIM21_OR_TI1_RMP_0; // LSI
+  TIM21->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_IC1PSC; // TI1, every 8th edge
+  TIM21->CCER = TIM_CCER_CC1E;
+  TIM21->EGR = TIM_EGR_UG;
+  TIM21->SR = 0;
+  TIM21->CR1 = TIM_CR1_CEN;
+
+  bool ok = true;
+  LsiCapture capture;
+  for (uint16_t i = 0; ok && (i <= captures); i++) {
+    uint32_t start = millis();
+    while ((TIM21->SR & TIM_SR_CC1IF) == 0) {
+      if (millis() - start > LSI_CAL_TIMEOUT) {
+        ok = false;
+        break;
+      }
+    }
+    // reading CCR1 clears CC1IF, an overcapture means a missed edge
+    capture.add(TIM21->CCR1);
+    if (TIM21->SR & TIM_SR_CC1OF) {
+      ok = false;
+    }
+  }
+
+  TIM21->CR1 = 0;
+  TIM21->CCER = 0;
+  TIM21->OR &= ~TIM21_OR_TI1_RMP;
+  __HAL_RCC_TIM21_CLK_DISABLE();
+  if (!ok) {
+    return false;
+  }
+
+  uint32_t timer_hz =
+      lsiTimerClock(HAL_RCC_GetPCLK2Freq(),
+                    (RCC->CFGR & RCC_CFGR_PPRE2) != RCC_CFGR_PPRE2_DIV1);
+  uint32_t correction = lsiCorrectionQ16(
+      (uint32_t)capture.intervals * LSI_CAL_IC_DIV, capture.ticks, timer_hz);
+  if (rct_Calibration_Time > 0) {
+    correction = (uint32_t)(((uint64_t)correction * RTC_CAL_DELAY +
+                             rct_Calibration_Time / 2) /
+                            rct_Calibration_Time);
+  }
+  setRTCTimeCorrectionQ16(correction);
+  return true;
+#else
+  (void)periods;
+  return false;
+#endif
+}
+
+// error in ppb of the 1 Hz calendar clock from RTCCLK clk (16.16 Hz) with
+// the prescalers a and s
+static int64_t prescalerError(uint64_t clk, uint32_t a, uint32_t s) {
+  return (int64_t)((clk * PPB) / (((uint64_t)(a + 1) * (s + 1)) << 16)) - PPB;
+}
+
+static bool inSmoothCalRange(int64_t error) {
+  return (error <= SMOOTH_CAL_RANGE_PPB) && (error >= -SMOOTH_CAL_RANGE_PPB);
+}
+
+/*
+  The measured RTCCLK is the nominal clock times the correction factor. The
+  current prescalers are kept while their 1 Hz error fits the smooth
+  calibration range, writing new ones stops the calendar. Otherwise the
+  largest asynchronous prescaler that fits is used, a high asynchronous
+  prescaler draws the least current. The smooth calibration masks (or with
+  CALP adds 512) RTCCLK pulses out of 2^20, it takes the error down to about
+  1 ppm. Only for the LSI, an LSE is left alone.
+*/
+bool STM32LowPowerCal::applyRTCCalibration() {
+#if defined(RTC_CALR_CALP)
+  STM32RTC &rtc = STM32RTC::getInstance();
+  rtc.begin();
+  if (rtc.getClockSource() != STM32RTC::LSI_CLOCK) {
+    return false;
+  }
+
+  // RTCCLK in 16.16 fixed point Hz
+  uint64_t clk = (uint64_t)LSI_VALUE * getRTCTimeCorrectionQ16();
+
+  int8_t a;
+  int16_t s;
+  rtc.getPrediv(&a, &s);
+  int64_t error = prescalerError(clk, a, s);
+  if ((a < 3) || !inSmoothCalRange(error)) {
+    for (a = PREDIVA_MAX; a >= 3; a--) {
+      uint64_t div = ((clk / (a + 1)) + (1UL << 15)) >> 16;
+      if ((div == 0) || (div - 1 > PREDIVS_MAX)) {
+        continue;
+      }
+      s = div - 1;
+      error = prescalerError(clk, a, s);
+      if (inSmoothCalRange(error)) {
+        break;
+      }
+    }
+    if (a < 3) {
+      return false;
+    }
+  }
+
+  // minus - 512 * plus pulses in 2^20 cancel the error
+  int32_t pulses = (int32_t)((error * (1L << 20) +
+                              (error >= 0 ? PPB / 2 : -PPB / 2)) /
+                             PPB);
+  bool plus = pulses < 0;
+  uint32_t minus = plus ? 512 + pulses : pulses;
+  if (!rtc.setCalibration(a, s, plus, minus)) {
+    return false;
+  }
+
+  rtc_Residual_ppb = (int32_t)(((PPB + error) * (1L << 20)) /
+                                   ((1L << 20) + pulses) -
+                               PPB);
+  rtc_Hardware_Calibrated = true;
+  return true;
+#else
+  return false;
+#endif
 }
 
 STM32LowPowerCal LowPowerCal;
\ No newline at end of file
@@ -11,6 +11,9 @@
 #ifndef _STM32_LOW_POWER_CAL_H_
 #define _STM32_LOW_POWER_CAL_H_
 
+// LSI periods measured by calibrateLSI(), a multiple of 8
+#define LSI_CAL_PERIODS 256
+
 class STM32LowPowerCal : public STM32LowPower {
 
 public:
@@ -19,14 +22,27 @@ public:
     deepSleep((uint32_t)ms, correction_Time);
   }
 
-  void setRTCCalibrationTime(float calibration_Time);
+  void setRTCCalibrationTime(uint32_t calibration_Time);
   void calibrateRTC();
-  float getRTCTimeCorrection();
+  // LSI against the system clock with TIM21 input capture, a few ms
+  bool calibrateLSI(uint16_t periods = LSI_CAL_PERIODS);
+  static uint32_t lsiCorrectionQ16(uint32_t periods, uint32_t ticks,
+                                   uint32_t timer_hz);
+  // moves the correction into the RTC prescalers and smooth calibration
+  bool applyRTCCalibration();
+  // calendar error left after applyRTCCalibration(), in ppb
+  int32_t getResidual_ppb() { return rtc_Residual_ppb; }
+  int32_t getRTCTimeCorrection_ppm();
+  // correction factor in 16.16 fixed point, for storing it
+  uint32_t getRTCTimeCorrectionQ16();
+  void setRTCTimeCorrectionQ16(uint32_t correction);
 
 private:
   // declare timing parameters
-  float rtc_Time_Correction_Factor;
-  float rct_Calibration_Time; // time it should be.
+  uint32_t rtc_Time_Correction_Q16 = 1UL << 16;
+  uint32_t rct_Calibration_Time; // time it should be, ms
+  bool rtc_Hardware_Calibrated;
+  int32_t rtc_Residual_ppb;
 };
 
 extern STM32LowPowerCal LowPowerCal;
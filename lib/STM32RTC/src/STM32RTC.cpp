@@ -34,12 +34,12 @@
   ******************************************************************************
   */
 
-#include <time.h>
-
 #include "STM32RTC.h"
+#include "rtc_calc.h"
 
 #define EPOCH_TIME_OFF      946684800  // This is 1st January 2000, 00:00:00 in epoch time
-#define EPOCH_TIME_YEAR_OFF 100        // years since 1900
+#define EPOCH_TIME_MAX      4102444799 // This is 31st December 2099, 23:59:59 in epoch time
+#define SECONDS_PER_DAY     86400
 
 // Initialize static variable
 bool STM32RTC::_timeSet = false;
@@ -252,6 +252,47 @@ void STM32RTC::detachSecondsInterrupt(void)
   detachSecondsIrqCallback();
 }
 
+#if defined(RTC_CR_WUTE)
+/**
+  * @brief start the wakeup timer in periodic mode.
+  * @param ms: period in milliseconds
+  * @retval false if the period can't be programmed
+  */
+bool STM32RTC::startWakeUpTimer(uint32_t ms)
+{
+  return RTC_StartWakeUpTimer(ms);
+}
+
+/**
+  * @brief stop the periodic wakeup timer.
+  * @retval None
+  */
+void STM32RTC::stopWakeUpTimer(void)
+{
+  RTC_StopWakeUpTimer();
+}
+
+/**
+  * @brief attach a callback to the wakeup timer interrupt.
+  * @param callback: pointer to the callback
+  * @param data: optional pointer to callback data parameters
+  * @retval None
+  */
+void STM32RTC::attachWakeUpInterrupt(voidFuncPtr callback, void *data)
+{
+  attachWakeUpTimerCallback(callback, data);
+}
+
+/**
+  * @brief detach the wakeup timer callback.
+  * @retval None
+  */
+void STM32RTC::detachWakeUpInterrupt(void)
+{
+  detachWakeUpTimerCallback();
+}
+#endif /* RTC_CR_WUTE */
+
 #endif /* ONESECOND_IRQn */
 // Kept for compatibility. Use STM32LowPower library.
 void STM32RTC::standbyMode(void)
@@ -403,6 +444,45 @@ void STM32RTC::getDate(uint8_t *weekDay, uint8_t *day, uint8_t *month, uint8_t *
   }
 }
 
+/**
+  * @brief  get RTC time, calendar and epoch from one read of the registers.
+  *         Unlike consecutive getters, the fields can't tear at a second or
+  *         day rollover.
+  * @retval snapshot of the RTC
+  */
+STM32RTC::Snapshot STM32RTC::getSnapshot(void)
+{
+  rtcSnapshot_t raw;
+  Snapshot snapshot;
+
+  RTC_GetSnapshot(&raw);
+#if defined(STM32F1xx)
+  RTC_StoreDate();
+#endif
+  _year = raw.year;
+  _month = raw.month;
+  _day = raw.day;
+  _wday = raw.wday;
+  _hours = raw.hours;
+  _minutes = raw.minutes;
+  _seconds = raw.seconds;
+  _subSeconds = raw.subSeconds;
+  _hoursPeriod = (raw.period == HOUR_AM) ? AM : PM;
+
+  snapshot.epoch = EPOCH_TIME_OFF + RTC_DaysFromCivil(_year, _month, _day) * SECONDS_PER_DAY +
+                   _hours * 3600U + _minutes * 60U + _seconds;
+  snapshot.subSeconds = (uint16_t)_subSeconds;
+  snapshot.year = _year;
+  snapshot.month = _month;
+  snapshot.day = _day;
+  snapshot.wday = _wday;
+  snapshot.hours = _hours;
+  snapshot.minutes = _minutes;
+  snapshot.seconds = _seconds;
+  snapshot.period = _hoursPeriod;
+  return snapshot;
+}
+
 /**
   * @brief  get RTC alarm subsecond.
   * @retval return the current alarm subsecond.
@@ -815,29 +895,13 @@ void STM32RTC::setAlarmDate(uint8_t day, uint8_t month, uint8_t year)
   */
 uint32_t STM32RTC::getEpoch(uint32_t *subSeconds)
 {
-  struct tm tm;
-
-  syncDate();
-  syncTime();
+  Snapshot snapshot = getSnapshot();
 
-  tm.tm_isdst = -1;
-  /*
-   * mktime ignores the values supplied by the caller in the
-   * tm_wday and tm_yday fields
-   */
-  tm.tm_yday = 0;
-  tm.tm_wday = 0;
-  tm.tm_year = _year + EPOCH_TIME_YEAR_OFF;
-  tm.tm_mon = _month - 1;
-  tm.tm_mday = _day;
-  tm.tm_hour = _hours;
-  tm.tm_min = _minutes;
-  tm.tm_sec = _seconds;
   if (subSeconds != nullptr) {
-    *subSeconds = _subSeconds;
+    *subSeconds = snapshot.subSeconds;
   }
 
-  return mktime(&tm);
+  return snapshot.epoch;
 }
 
 /**
@@ -857,17 +921,22 @@ uint32_t STM32RTC::getY2kEpoch(void)
   */
 void STM32RTC::setAlarmEpoch(uint32_t ts, Alarm_Match match, uint32_t subSeconds)
 {
+  uint8_t year, month, day, wday;
+
   if (ts < EPOCH_TIME_OFF) {
     ts = EPOCH_TIME_OFF;
+  } else if (ts > EPOCH_TIME_MAX) {
+    ts = EPOCH_TIME_MAX;
   }
 
-  time_t t = ts;
-  struct tm *tmp = gmtime(&t);
+  ts -= EPOCH_TIME_OFF;
+  RTC_CivilFromDays(ts / SECONDS_PER_DAY, &year, &month, &day, &wday);
+  ts %= SECONDS_PER_DAY;
 
-  setAlarmDay(tmp->tm_mday);
-  setAlarmHours(tmp->tm_hour);
-  setAlarmMinutes(tmp->tm_min);
-  setAlarmSeconds(tmp->tm_sec);
+  setAlarmDay(day);
+  setAlarmHours(ts / 3600);
+  setAlarmMinutes((ts / 60) % 60);
+  setAlarmSeconds(ts % 60);
   setAlarmSubSeconds(subSeconds);
   enableAlarm(match);
 }
@@ -881,22 +950,17 @@ void STM32RTC::setEpoch(uint32_t ts, uint32_t subSeconds)
 {
   if (ts < EPOCH_TIME_OFF) {
     ts = EPOCH_TIME_OFF;
+  } else if (ts > EPOCH_TIME_MAX) {
+    ts = EPOCH_TIME_MAX;
   }
 
-  time_t t = ts;
-  struct tm *tmp = gmtime(&t);
+  ts -= EPOCH_TIME_OFF;
+  RTC_CivilFromDays(ts / SECONDS_PER_DAY, &_year, &_month, &_day, &_wday);
+  ts %= SECONDS_PER_DAY;
 
-  _year = tmp->tm_year - EPOCH_TIME_YEAR_OFF;
-  _month = tmp->tm_mon + 1;
-  _day = tmp->tm_mday;
-  if (tmp->tm_wday == 0) {
-    _wday = RTC_WEEKDAY_SUNDAY;
-  } else {
-    _wday = tmp->tm_wday;
-  }
-  _hours = tmp->tm_hour;
-  _minutes = tmp->tm_min;
-  _seconds = tmp->tm_sec;
+  _hours = ts / 3600;
+  _minutes = (ts / 60) % 60;
+  _seconds = ts % 60;
   _subSeconds = subSeconds;
 
   RTC_SetDate(_year, _month, _day, _wday);
@@ -101,6 +101,20 @@ class STM32RTC {
       HSE_CLOCK = ::HSE_CLOCK
     };
 
+    // Time and calendar from a single read of the RTC registers
+    struct Snapshot {
+      uint32_t epoch;      // seconds since 1st January 1970
+      uint16_t subSeconds; // milliseconds
+      uint8_t  year;
+      uint8_t  month;
+      uint8_t  day;
+      uint8_t  wday;
+      uint8_t  hours;
+      uint8_t  minutes;
+      uint8_t  seconds;
+      AM_PM    period;
+    };
+
     static STM32RTC &getInstance()
     {
       static STM32RTC instance; // Guaranteed to be destroyed.
@@ -130,6 +144,14 @@ class STM32RTC {
     void attachSecondsInterrupt(voidFuncPtr callback);
     void detachSecondsInterrupt(void);
 
+#if defined(RTC_CR_WUTE)
+    // Periodic wakeup timer, reloaded by the hardware. Shares the WakeUp
+    // feature with the Seconds interrupt.
+    bool startWakeUpTimer(uint32_t ms);
+    void stopWakeUpTimer(void);
+    void attachWakeUpInterrupt(voidFuncPtr callback, void *data = nullptr);
+    void detachWakeUpInterrupt(void);
+#endif /* RTC_CR_WUTE */
 #endif /* ONESECOND_IRQn */
     // Kept for compatibility: use STM32LowPower library.
     void standbyMode();
@@ -148,6 +170,8 @@ class STM32RTC {
     uint8_t getYear(void);
     void getDate(uint8_t *weekDay, uint8_t *day, uint8_t *month, uint8_t *year);
 
+    Snapshot getSnapshot(void);
+
     uint32_t getAlarmSubSeconds(void);
     uint8_t getAlarmSeconds(void);
     uint8_t getAlarmMinutes(void);
@@ -202,6 +226,13 @@ class STM32RTC {
     void getPrediv(int8_t *predivA, int16_t *predivS);
     void setPrediv(int8_t predivA, int16_t predivS);
 #endif /* STM32F1xx */
+#if defined(RTC_CALR_CALP)
+    // prescalers and smooth calibration for a measured RTCCLK
+    bool setCalibration(int8_t predivA, int16_t predivS, bool plus, uint16_t minus)
+    {
+      return RTC_SetCalibration(predivA, predivS, plus, minus);
+    }
+#endif
     bool isConfigured(void)
     {
       return RTC_IsConfigured();
@@ -35,6 +35,7 @@
   */
 
 #include "rtc.h"
+#include "rtc_calc.h"
 #include "stm32yyxx_ll_rtc.h"
 #include <string.h>
 
@@ -61,6 +62,10 @@ static RTC_HandleTypeDef RtcHandle = {0};
 static voidCallbackPtr RTCUserCallback = NULL;
 static void *callbackUserData = NULL;
 static voidCallbackPtr RTCSecondsIrqCallback = NULL;
+#if defined(ONESECOND_IRQn) && defined(RTC_CR_WUTE)
+static voidCallbackPtr RTCWakeUpCallback = NULL;
+static void *wakeUpUserData = NULL;
+#endif
 
 static sourceClock_t clkSrc = LSI_CLOCK;
 static uint8_t HSEDiv = 0;
@@ -464,7 +469,10 @@ bool RTC_init(hourFormat_t format, sourceClock_t source, bool reset)
       RTC_SetDate(RtcHandle.DateToUpdate.Year, RtcHandle.DateToUpdate.Month,
                   RtcHandle.DateToUpdate.Date, RtcHandle.DateToUpdate.WeekDay);
 #else
-      // This initialize variables: predivAsync, predivSync and predivSync_bits
+      // The prescalers may be calibrated, take them from the RTC
+      predivAsync = (int8_t)LL_RTC_GetAsynchPrescaler(RtcHandle.Instance);
+      predivSync = (int16_t)LL_RTC_GetSynchPrescaler(RtcHandle.Instance);
+      // This initialize variable predivSync_bits
       RTC_getPrediv(NULL, NULL);
 #endif // STM32F1xx
     }
@@ -645,6 +653,92 @@ void RTC_GetDate(uint8_t *year, uint8_t *month, uint8_t *day, uint8_t *wday)
   }
 }
 
+/**
+  * @brief Request a new copy of the calendar in the shadow registers
+  * @note  The shadow registers are not updated in stop mode, RSF stays set
+  *        with the time of the stop entry. Call after a wakeup, the next
+  *        RTC_GetSnapshot() then waits for RSF. Nothing to do with BYPSHAD.
+  * @retval None
+  */
+void RTC_ResyncShadow(void)
+{
+#if !defined(STM32F1xx)
+#if defined(RTC_CR_BYPSHAD)
+  if (LL_RTC_IsShadowRegBypassEnabled(RtcHandle.Instance)) {
+    return;
+  }
+#endif /* RTC_CR_BYPSHAD */
+  LL_RTC_DisableWriteProtection(RtcHandle.Instance);
+  LL_RTC_ClearFlag_RS(RtcHandle.Instance);
+  LL_RTC_EnableWriteProtection(RtcHandle.Instance);
+#endif /* !STM32F1xx */
+}
+
+/**
+  * @brief Get RTC time and calendar in one pass
+  * @note  Through the shadow registers SSR, TR and DR are read once in this
+  *        order: reading SSR locks TR and DR until DR is read, and RSF
+  *        tells the copy is valid. RSF is cleared afterwards, so a read
+  *        within the next two RTCCLK periods waits for a new copy. With
+  *        BYPSHAD the counters are read directly, the three reads are
+  *        repeated until two passes agree. DR is always read last.
+  * @param snapshot: decoded time and calendar, subSeconds in milliseconds
+  * @retval None
+  */
+void RTC_GetSnapshot(rtcSnapshot_t *snapshot)
+{
+  if (snapshot == NULL) {
+    return;
+  }
+#if defined(STM32F1xx)
+  RTC_GetTime(&snapshot->hours, &snapshot->minutes, &snapshot->seconds,
+              &snapshot->subSeconds, &snapshot->period);
+  RTC_GetDate(&snapshot->year, &snapshot->month, &snapshot->day, &snapshot->wday);
+#else
+  uint32_t ssr, tr, dr;
+
+#if defined(RTC_CR_BYPSHAD)
+  if (LL_RTC_IsShadowRegBypassEnabled(RtcHandle.Instance)) {
+    uint32_t lastSsr, lastTr, lastDr;
+
+    ssr = RtcHandle.Instance->SSR;
+    tr = RtcHandle.Instance->TR;
+    dr = RtcHandle.Instance->DR;
+    do {
+      lastSsr = ssr;
+      lastTr = tr;
+      lastDr = dr;
+      ssr = RtcHandle.Instance->SSR;
+      tr = RtcHandle.Instance->TR;
+      dr = RtcHandle.Instance->DR;
+    } while ((ssr != lastSsr) || (tr != lastTr) || (dr != lastDr));
+  } else
+#endif /* RTC_CR_BYPSHAD */
+  {
+    while (!LL_RTC_IsActiveFlag_RS(RtcHandle.Instance));
+    ssr = RtcHandle.Instance->SSR;
+    tr = RtcHandle.Instance->TR;
+    dr = RtcHandle.Instance->DR;
+    RTC_ResyncShadow();
+  }
+
+  snapshot->hours = RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos));
+  snapshot->minutes = RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos));
+  snapshot->seconds = RTC_Bcd2ToByte((uint8_t)((tr & (RTC_TR_ST | RTC_TR_SU)) >> RTC_TR_SU_Pos));
+  snapshot->period = (tr & RTC_TR_PM) ? HOUR_PM : HOUR_AM;
+  snapshot->year = RTC_Bcd2ToByte((uint8_t)((dr & (RTC_DR_YT | RTC_DR_YU)) >> RTC_DR_YU_Pos));
+  snapshot->month = RTC_Bcd2ToByte((uint8_t)((dr & (RTC_DR_MT | RTC_DR_MU)) >> RTC_DR_MU_Pos));
+  snapshot->day = RTC_Bcd2ToByte((uint8_t)((dr & (RTC_DR_DT | RTC_DR_DU)) >> RTC_DR_DU_Pos));
+  snapshot->wday = (uint8_t)((dr & RTC_DR_WDU) >> RTC_DR_WDU_Pos);
+#if defined(RTC_SSR_SS)
+  snapshot->subSeconds = (((uint32_t)predivSync - ssr) * 1000) / (predivSync + 1);
+#else
+  UNUSED(ssr);
+  snapshot->subSeconds = 0;
+#endif /* RTC_SSR_SS */
+#endif /* STM32F1xx */
+}
+
 /**
   * @brief Set RTC alarm and activate it with IT mode
   * @param day: 1-31 (day of the month)
@@ -863,6 +957,11 @@ void HAL_RTC_AlarmAEventCallback(RTC_HandleTypeDef *hrtc)
 void RTC_Alarm_IRQHandler(void)
 {
   HAL_RTC_AlarmIRQHandler(&RtcHandle);
+#if defined(STM32L0xx) || (defined(STM32F0xx) && defined(RTC_CR_WUTE))
+  /* alarm and wakeup timer share the RTC vector, RTC_WKUP_IRQHandler is
+     never called on these series */
+  HAL_RTCEx_WakeUpTimerIRQHandler(&RtcHandle);
+#endif
 }
 
 #ifdef ONESECOND_IRQn
@@ -940,6 +1039,78 @@ void RTC_IRQHandler(void)
 }
 
 #else
+#if defined(RTC_CR_WUTE)
+/**
+  * @brief Start the wakeup timer in periodic mode. The counter reloads in
+  *        hardware, so the period is programmed once and every wakeup only
+  *        clears the flag.
+  * @note  The wakeup timer replaces the One-Second interrupt.
+  * @param ms: period in milliseconds of the calendar clock, see
+  *        RTC_WakeUpTimerTicks() for the range
+  * @retval false if the period is out of range
+  */
+bool RTC_StartWakeUpTimer(uint32_t ms)
+{
+  wakeUpClock_t clock;
+  uint32_t wakeUpClock;
+  uint32_t rtcclk;
+  uint32_t ticks;
+
+  /* RTCCLK as seen by the calendar, (predivA + 1) * (predivS + 1) = 1 Hz */
+  RTC_getPrediv(NULL, NULL);
+  rtcclk = (uint32_t)(predivAsync + 1) * (uint32_t)(predivSync + 1);
+
+  if (!RTC_WakeUpTimerTicks(ms, rtcclk, &clock, &ticks)) {
+    return false;
+  }
+  wakeUpClock = (clock == WAKEUP_CLOCK_CK_SPRE) ? RTC_WAKEUPCLOCK_CK_SPRE_16BITS
+                : RTC_WAKEUPCLOCK_RTCCLK_DIV16;
+
+  /* the timer fires after WUT + 1 ticks */
+#if defined(RTC_WUTR_WUTOCLR)
+  HAL_RTCEx_SetWakeUpTimer_IT(&RtcHandle, ticks - 1, wakeUpClock, 0);
+#else
+  HAL_RTCEx_SetWakeUpTimer_IT(&RtcHandle, ticks - 1, wakeUpClock);
+#endif /* RTC_WUTR_WUTOCLR */
+  HAL_NVIC_SetPriority(ONESECOND_IRQn, RTC_IRQ_PRIO, RTC_IRQ_SUBPRIO);
+  HAL_NVIC_EnableIRQ(ONESECOND_IRQn);
+  return true;
+}
+
+/**
+  * @brief Stop the periodic wakeup timer.
+  * @param None
+  * @retval None
+  */
+void RTC_StopWakeUpTimer(void)
+{
+  HAL_RTCEx_DeactivateWakeUpTimer(&RtcHandle);
+}
+
+/**
+  * @brief Attach wakeup timer callback.
+  * @param func: pointer to the callback
+  * @param data: pointer to the callback data parameter
+  * @retval None
+  */
+void attachWakeUpTimerCallback(voidCallbackPtr func, void *data)
+{
+  RTCWakeUpCallback = func;
+  wakeUpUserData = data;
+}
+
+/**
+  * @brief Detach wakeup timer callback.
+  * @param None
+  * @retval None
+  */
+void detachWakeUpTimerCallback(void)
+{
+  RTCWakeUpCallback = NULL;
+  wakeUpUserData = NULL;
+}
+#endif /* RTC_CR_WUTE */
+
 /**
   * @brief  WakeUp event mapping the Seconds interrupt callback.
   * @param  hrtc RTC handle
@@ -952,6 +1123,11 @@ void HAL_RTCEx_WakeUpTimerEventCallback(RTC_HandleTypeDef *hrtc)
   if (RTCSecondsIrqCallback != NULL) {
     RTCSecondsIrqCallback(NULL);
   }
+#if defined(RTC_CR_WUTE)
+  if (RTCWakeUpCallback != NULL) {
+    RTCWakeUpCallback(wakeUpUserData);
+  }
+#endif
 }
 
 /**
@@ -966,6 +1142,48 @@ void RTC_WKUP_IRQHandler(void)
 #endif /* STM32F1xx */
 #endif /* ONESECOND_IRQn */
 
+#if defined(RTC_CALR_CALP)
+/**
+  * @brief Calibrate the calendar clock: prescalers for the measured RTCCLK
+  *        and the smooth calibration over 32 s for the remainder.
+  * @note  Writing the prescalers stops the calendar in init mode, the
+  *        fraction of the current second is lost. Unchanged prescalers are
+  *        not written again.
+  * @param asynch: asynchronous prescaler value, at least 3 with plus
+  * @param synch: synchronous prescaler value
+  * @param plus: insert one RTCCLK pulse every 2^11 pulses (+488.5 ppm)
+  * @param minus: pulses masked in 2^20 (0.954 ppm each), 0 - 511
+  * @retval false if a value is out of range
+  */
+bool RTC_SetCalibration(int8_t asynch, int16_t synch, bool plus, uint32_t minus)
+{
+  if ((asynch < (plus ? 3 : 0)) || ((uint32_t)asynch > PREDIVA_MAX) ||
+      (synch < 0) || ((uint32_t)synch > PREDIVS_MAX) || (minus > 0x1FF)) {
+    return false;
+  }
+
+  if ((LL_RTC_GetAsynchPrescaler(RtcHandle.Instance) != (uint32_t)asynch) ||
+      (LL_RTC_GetSynchPrescaler(RtcHandle.Instance) != (uint32_t)synch)) {
+    LL_RTC_DisableWriteProtection(RtcHandle.Instance);
+    LL_RTC_EnableInitMode(RtcHandle.Instance);
+    while (!LL_RTC_IsActiveFlag_INIT(RtcHandle.Instance));
+    LL_RTC_SetSynchPrescaler(RtcHandle.Instance, (uint32_t)synch);
+    LL_RTC_SetAsynchPrescaler(RtcHandle.Instance, (uint32_t)asynch);
+    LL_RTC_DisableInitMode(RtcHandle.Instance);
+    LL_RTC_EnableWriteProtection(RtcHandle.Instance);
+  }
+  RtcHandle.Init.AsynchPrediv = (uint32_t)asynch;
+  RtcHandle.Init.SynchPrediv = (uint32_t)synch;
+  predivAsync = asynch;
+  predivSync = synch;
+  predivSync_bits = (uint8_t)_log2(predivSync) + 1;
+
+  return HAL_RTCEx_SetSmoothCalib(&RtcHandle, RTC_SMOOTHCALIB_PERIOD_32SEC,
+                                  plus ? RTC_SMOOTHCALIB_PLUSPULSES_SET : RTC_SMOOTHCALIB_PLUSPULSES_RESET,
+                                  minus) == HAL_OK;
+}
+#endif /* RTC_CALR_CALP */
+
 #if defined(STM32F1xx)
 void RTC_StoreDate(void)
 {
@@ -76,6 +76,19 @@ typedef enum {
 
 typedef void(*voidCallbackPtr)(void *);
 
+/* Calendar and time read in one pass, see RTC_GetSnapshot() */
+typedef struct {
+  uint32_t subSeconds; /* 0-999 */
+  uint8_t year;        /* 0-99 */
+  uint8_t month;       /* 1-12 */
+  uint8_t day;         /* 1-31 */
+  uint8_t wday;        /* 1-7 */
+  uint8_t hours;
+  uint8_t minutes;
+  uint8_t seconds;
+  hourAM_PM_t period;
+} rtcSnapshot_t;
+
 /* Exported constants --------------------------------------------------------*/
 
 #if defined(STM32F1xx)
@@ -188,6 +201,9 @@ void RTC_GetTime(uint8_t *hours, uint8_t *minutes, uint8_t *seconds, uint32_t *s
 void RTC_SetDate(uint8_t year, uint8_t month, uint8_t day, uint8_t wday);
 void RTC_GetDate(uint8_t *year, uint8_t *month, uint8_t *day, uint8_t *wday);
 
+void RTC_GetSnapshot(rtcSnapshot_t *snapshot);
+void RTC_ResyncShadow(void);
+
 void RTC_StartAlarm(uint8_t day, uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds, hourAM_PM_t period, uint8_t mask);
 void RTC_StopAlarm(void);
 bool RTC_IsAlarmSet(void);
@@ -197,8 +213,18 @@ void detachAlarmCallback(void);
 #ifdef ONESECOND_IRQn
 void attachSecondsIrqCallback(voidCallbackPtr func);
 void detachSecondsIrqCallback(void);
+#if defined(RTC_CR_WUTE)
+bool RTC_StartWakeUpTimer(uint32_t ms);
+void RTC_StopWakeUpTimer(void);
+void attachWakeUpTimerCallback(voidCallbackPtr func, void *data);
+void detachWakeUpTimerCallback(void);
+#endif /* RTC_CR_WUTE */
 #endif /* ONESECOND_IRQn */
 
+#if defined(RTC_CALR_CALP)
+bool RTC_SetCalibration(int8_t asynch, int16_t synch, bool plus, uint32_t minus);
+#endif
+
 #if defined(STM32F1xx)
 void RTC_StoreDate(void);
 #endif
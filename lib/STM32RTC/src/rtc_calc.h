@@ -0,0 +1,138 @@
+/**
+  ******************************************************************************
+  * @file    rtc_calc.h
+  * @brief   Integer arithmetic of the RTC driver. No HAL access, so it also
+  *          builds in the host tests.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __RTC_CALC_H
+#define __RTC_CALC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported constants --------------------------------------------------------*/
+#define RTC_DAYS_PER_4_YEARS 1461 /* 3 * 365 + 366 */
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum {
+  WAKEUP_CLOCK_RTCCLK_DIV16, /* RTCCLK / 16, about 0.43 ms with the LSI */
+  WAKEUP_CLOCK_CK_SPRE       /* 1 Hz calendar clock */
+} wakeUpClock_t;
+
+/* Exported functions ------------------------------------------------------- */
+
+/**
+  * @brief Wakeup timer clock and tick count of a period. RTCCLK/16 is used
+  *        up to 65536 ticks (about 28 s with the LSI), the 1 Hz ck_spre with
+  *        whole seconds above that.
+  * @param ms: period in milliseconds of the calendar clock
+  * @param rtcclk: RTCCLK as seen by the calendar, (predivA + 1) * (predivS + 1)
+  * @param clock: selected wakeup clock
+  * @param ticks: ticks of the selected clock per period, WUTR is ticks - 1
+  * @retval false if the period is out of range
+  */
+static inline bool RTC_WakeUpTimerTicks(uint32_t ms, uint32_t rtcclk,
+                                        wakeUpClock_t *clock, uint32_t *ticks)
+{
+  uint64_t counter = ((uint64_t)ms * rtcclk + 8000) / 16000;
+
+  *clock = WAKEUP_CLOCK_RTCCLK_DIV16;
+  if (counter > 0x10000) {
+    *clock = WAKEUP_CLOCK_CK_SPRE;
+    counter = ((uint64_t)ms + 500) / 1000;
+  }
+  if ((counter == 0) || (counter > 0x10000)) {
+    return false;
+  }
+  *ticks = (uint32_t)counter;
+  return true;
+}
+
+/**
+  * @brief  days of the months before month in a common year
+  * @param  month: 0 (January) to 11
+  * @retval days
+  */
+static inline uint16_t RTC_DaysBeforeMonth(uint32_t month)
+{
+  static const uint16_t daysBeforeMonth[12] = {
+    0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334
+  };
+  return daysBeforeMonth[month];
+}
+
+/**
+  * @brief  days since 1st January 2000 of a date of the RTC calendar
+  * @note   Only valid for 2000 to 2099, where every fourth year is a leap year
+  * @param  year: 0 to 99
+  * @param  month: 1 to 12
+  * @param  day: 1 to 31
+  * @retval days
+  */
+static inline uint32_t RTC_DaysFromCivil(uint8_t year, uint8_t month, uint8_t day)
+{
+  uint32_t days = 365U * year + ((year + 3U) >> 2) + RTC_DaysBeforeMonth(month - 1U) + day - 1;
+
+  if (((year & 3) == 0) && (month > 2)) {
+    days++;
+  }
+  return days;
+}
+
+/**
+  * @brief  RTC calendar date of a day count since 1st January 2000
+  * @note   Only valid for 2000 to 2099, where every fourth year is a leap year
+  * @param  days: days since 1st January 2000
+  * @param  year: 0 to 99
+  * @param  month: 1 to 12
+  * @param  day: 1 to 31
+  * @param  wday: RTC_WEEKDAY_MONDAY (1) to RTC_WEEKDAY_SUNDAY (7)
+  */
+static inline void RTC_CivilFromDays(uint32_t days, uint8_t *year, uint8_t *month,
+                                     uint8_t *day, uint8_t *wday)
+{
+  uint32_t cycle = days / RTC_DAYS_PER_4_YEARS;
+  uint32_t yday = days % RTC_DAYS_PER_4_YEARS;
+  uint32_t y = cycle * 4;
+  uint32_t m;
+
+  /* 1st January 2000 was a Saturday */
+  *wday = (uint8_t)((days + 5) % 7 + 1);
+
+  /* the first year of every cycle is the leap year */
+  if (yday >= 366) {
+    y += (yday - 1) / 365;
+    yday = (yday - 1) % 365;
+  } else if (yday >= 59) {
+    if (yday == 59) {
+      *year = (uint8_t)y;
+      *month = 2;
+      *day = 29;
+      return;
+    }
+    yday--;
+  }
+
+  /* every month has at least 28 days, so yday / 32 is the month or the one
+     before it */
+  m = yday >> 5;
+  if ((m < 11) && (yday >= RTC_DaysBeforeMonth(m + 1))) {
+    m++;
+  }
+  *year = (uint8_t)y;
+  *month = (uint8_t)(m + 1);
+  *day = (uint8_t)(yday - RTC_DaysBeforeMonth(m) + 1);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RTC_CALC_H */
@@ -0,0 +1,48 @@
+/*
+@file   STM32Retention.cpp
+@brief  Standby retention in the RTC backup registers
+*/
+
+#include "STM32Retention.h"
+#include "STM32DataEEPROM.h"
+#include "STM32RTC.h"
+
+#define RETENTION_MAGIC 0x5200
+
+STM32Retention Retention;
+
+/*
+  Register 0 holds the magic with the version in its low byte and a check
+  over the fields, registers 1 to 3 the fields. The registers are only
+  cleared by a backup domain reset, so a reset by NRST also finds them.
+*/
+bool STM32Retention::load() {
+  enableBackupDomain();
+  uint32_t head = getBackupRegister(RETENTION_BKP_FIRST);
+  sequence = getBackupRegister(RETENTION_BKP_FIRST + 1);
+  rtcCorrectionQ16 = getBackupRegister(RETENTION_BKP_FIRST + 2);
+  timebaseEpoch = getBackupRegister(RETENTION_BKP_FIRST + 3);
+
+  return ((head >> 16) == (RETENTION_MAGIC | RETENTION_VERSION)) &&
+         ((head & 0xFFFF) == check());
+}
+
+void STM32Retention::save() {
+  enableBackupDomain();
+  setBackupRegister(RETENTION_BKP_FIRST + 1, sequence);
+  setBackupRegister(RETENTION_BKP_FIRST + 2, rtcCorrectionQ16);
+  setBackupRegister(RETENTION_BKP_FIRST + 3, timebaseEpoch);
+  setBackupRegister(RETENTION_BKP_FIRST,
+                    ((uint32_t)(RETENTION_MAGIC | RETENTION_VERSION) << 16) |
+                        check());
+}
+
+void STM32Retention::invalidate() {
+  enableBackupDomain();
+  setBackupRegister(RETENTION_BKP_FIRST, 0);
+}
+
+uint16_t STM32Retention::check() {
+  uint32_t fields[3] = {sequence, rtcCorrectionQ16, timebaseEpoch};
+  return STM32DataEEPROM::crc32(fields, sizeof(fields)) & 0xFFFF;
+}
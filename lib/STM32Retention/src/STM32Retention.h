@@ -0,0 +1,37 @@
+/*
+@file   STM32Retention.h
+@brief  Application state kept in the RTC backup registers across standby.
+        Standby resets the MCU, the backup domain keeps 5 x 32 bits. The
+        larger warm boot data (BME280 trimming) stays in the boot cache in
+        data EEPROM, which would wear out if written on every cycle.
+*/
+
+#ifndef _STM32_RETENTION_H_
+#define _STM32_RETENTION_H_
+
+#include <Arduino.h>
+
+// first of the 4 backup registers used, LL_RTC_BKP_DR4 is left free
+#define RETENTION_BKP_FIRST LL_RTC_BKP_DR0
+
+// increase when the record layout changes
+#define RETENTION_VERSION 1
+
+class STM32Retention {
+
+public:
+  bool load();
+  void save();
+  void invalidate();
+
+  uint32_t sequence;         // packet counter
+  uint32_t rtcCorrectionQ16; // RTC time correction factor, 16.16 fixed point
+  uint32_t timebaseEpoch;    // RTC epoch of the time base zero
+
+private:
+  uint16_t check();
+};
+
+extern STM32Retention Retention;
+
+#endif // _STM32_RETENTION_H_
@@ -0,0 +1,157 @@
+/*
+@file   STM32SleepGovernor.cpp
+@brief  Sleep mode selection by time to the next event
+*/
+
+#include "STM32SleepGovernor.h"
+#include "STM32Timebase.h"
+
+// calibration runs per mode, the RTC alarm rounds every single run to a
+// subsecond step
+#define CAL_RUNS 8
+
+// longest plausible latency, the PLL lock after stop takes well below it
+#define CAL_MAX_LATENCY_US 20000
+
+STM32SleepGovernor SleepGovernor;
+
+/*
+  STM32L051 datasheet values with the LSI RTC running. The stop latency is
+  mostly the PLL lock in SystemClock_ConfigFromStop(), calibrate() replaces
+  the latencies with measured ones.
+*/
+STM32SleepGovernor::STM32SleepGovernor() {
+  _modes[IDLE_MODE] = {5, 1500000};
+  _modes[SLEEP_MODE] = {10, 1200000};
+  _modes[DEEP_SLEEP_MODE] = {300, 1200};
+}
+
+/*
+  One step of the RTC subsecond counter in us, the resolution of the time
+  base: ck_apre runs at predivS + 1 Hz, about 3.5 ms with the LSI
+  prescalers. The time base never resolves less than a whole ms.
+*/
+static uint32_t subsecondStep_us() {
+  int8_t predivA;
+  int16_t predivS;
+  STM32RTC::getInstance().getPrediv(&predivA, &predivS);
+  uint32_t step_us = 1000000UL / ((uint32_t)predivS + 1);
+  return (step_us > 1000) ? step_us : 1000;
+}
+
+// mean length in us of one wait of SLEEP_GOVERNOR_CAL_TIME in the mode
+static uint32_t measureRun_us(LP_Mode mode) {
+  uint64_t start = Timebase.getMillis();
+  for (uint8_t i = 0; i < CAL_RUNS; i++) {
+    switch (mode) {
+    case IDLE_MODE:
+      LowPower.idle(SLEEP_GOVERNOR_CAL_TIME);
+      break;
+    case SLEEP_MODE:
+      LowPower.sleep(SLEEP_GOVERNOR_CAL_TIME);
+      break;
+    default:
+      LowPower.deepSleep(SLEEP_GOVERNOR_CAL_TIME);
+      break;
+    }
+  }
+  return (uint32_t)((Timebase.getMillis() - start) * 1000 / CAL_RUNS);
+}
+
+/*
+  Measures the overhead of every mode over a sleep of known length on the
+  RTC time base. SysTick is suspended in idle and sleep as well as in stop
+  mode, so micros() can't time any of them. A latency below the time base
+  resolution keeps the datasheet value. Returns false when a mode failed the
+  sanity check, that mode keeps its previous latency.
+*/
+bool STM32SleepGovernor::calibrate() {
+  const uint32_t cal_us = SLEEP_GOVERNOR_CAL_TIME * 1000UL;
+  // a mean run more than one subsecond short of the sleep means the alarm
+  // fired early or the time base stood still
+  const uint32_t step_us = subsecondStep_us();
+  const uint32_t resolution_us = step_us / CAL_RUNS;
+  bool ok = true;
+
+  for (uint8_t m = 0; m < SLEEP_GOVERNOR_MODES; m++) {
+    uint32_t run_us = measureRun_us((LP_Mode)m);
+    if ((run_us + step_us < cal_us) ||
+        (run_us > cal_us + CAL_MAX_LATENCY_US)) {
+      ok = false;
+      continue;
+    }
+    if (run_us > cal_us + resolution_us) {
+      _modes[m].latency_us = run_us - cal_us;
+    }
+  }
+  return ok;
+}
+
+// charge of a wait of ms in the mode, the latency runs at run current
+uint64_t STM32SleepGovernor::getCharge_nC(LP_Mode mode, uint32_t ms) {
+  uint64_t wait_us = (uint64_t)ms * 1000;
+  uint64_t latency_us = _modes[mode].latency_us;
+  uint64_t resident_us = (wait_us > latency_us) ? wait_us - latency_us : 0;
+
+  return (latency_us * _runCurrent_uA) / 1000 +
+         (resident_us * _modes[mode].current_nA) / 1000000;
+}
+
+// the mode with the lowest charge that wakes up in time
+LP_Mode STM32SleepGovernor::select(uint32_t ms) {
+  LP_Mode best = IDLE_MODE;
+  uint64_t best_nC = getCharge_nC(IDLE_MODE, ms);
+
+  for (uint8_t m = SLEEP_MODE; m < SLEEP_GOVERNOR_MODES; m++) {
+    LP_Mode mode = (LP_Mode)m;
+    if (_modes[mode].latency_us > (uint64_t)ms * 1000) {
+      continue;
+    }
+    uint64_t charge_nC = getCharge_nC(mode, ms);
+    if (charge_nC < best_nC) {
+      best = mode;
+      best_nC = charge_nC;
+    }
+  }
+  return best;
+}
+
+void STM32SleepGovernor::sleep(uint32_t ms) {
+  if (ms < SLEEP_GOVERNOR_MIN_SLEEP) {
+    delay(ms);
+    return;
+  }
+  LP_Mode mode = select(ms);
+  // wake up early by the latency, so the event is not late
+  uint32_t latency_ms = (_modes[mode].latency_us + 999) / 1000;
+  if (ms > latency_ms + SLEEP_GOVERNOR_MIN_SLEEP) {
+    ms -= latency_ms;
+  }
+  switch (mode) {
+  case IDLE_MODE:
+    LowPower.idle(ms);
+    break;
+  case SLEEP_MODE:
+    LowPower.sleep(ms);
+    break;
+  default:
+    LowPower.deepSleep(ms);
+    break;
+  }
+}
+
+uint32_t STM32SleepGovernor::getLatency_us(LP_Mode mode) {
+  return (mode < SLEEP_GOVERNOR_MODES) ? _modes[mode].latency_us : 0;
+}
+
+void STM32SleepGovernor::setLatency_us(LP_Mode mode, uint32_t latency_us) {
+  if (mode < SLEEP_GOVERNOR_MODES) {
+    _modes[mode].latency_us = latency_us;
+  }
+}
+
+void STM32SleepGovernor::setCurrent_nA(LP_Mode mode, uint32_t current_nA) {
+  if (mode < SLEEP_GOVERNOR_MODES) {
+    _modes[mode].current_nA = current_nA;
+  }
+}
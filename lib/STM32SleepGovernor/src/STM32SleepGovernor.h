@@ -0,0 +1,54 @@
+/*
+@file   STM32SleepGovernor.h
+@brief  Picks idle, sleep or deepSleep for a known time to the next event.
+        Every mode has an entry plus exit latency spent at run current and a
+        residency current, the mode with the lowest total charge wins.
+*/
+
+#ifndef _STM32_SLEEP_GOVERNOR_H_
+#define _STM32_SLEEP_GOVERNOR_H_
+
+#include <Arduino.h>
+#include "STM32LowPower.h"
+
+// modes the governor chooses from, shutdown loses the RAM and is left out
+#define SLEEP_GOVERNOR_MODES 3
+
+// run current at 32 MHz in uA, charged for the latency of a mode
+#define SLEEP_GOVERNOR_RUN_CURRENT_UA 6400
+
+// shorter waits are spent in delay(), the RTC alarm can't resolve them
+#define SLEEP_GOVERNOR_MIN_SLEEP 10
+
+// sleep time of one calibration run in ms
+#define SLEEP_GOVERNOR_CAL_TIME 100
+
+class STM32SleepGovernor {
+
+public:
+  STM32SleepGovernor();
+
+  bool calibrate();
+  LP_Mode select(uint32_t ms);
+  void sleep(uint32_t ms);
+
+  uint64_t getCharge_nC(LP_Mode mode, uint32_t ms);
+
+  uint32_t getLatency_us(LP_Mode mode);
+  void setLatency_us(LP_Mode mode, uint32_t latency_us);
+  void setCurrent_nA(LP_Mode mode, uint32_t current_nA);
+  void setRunCurrent_uA(uint32_t current_uA) { _runCurrent_uA = current_uA; }
+
+private:
+  struct Mode {
+    uint32_t latency_us; // entry plus exit, at run current
+    uint32_t current_nA; // while in the mode
+  };
+
+  Mode _modes[SLEEP_GOVERNOR_MODES];
+  uint32_t _runCurrent_uA = SLEEP_GOVERNOR_RUN_CURRENT_UA;
+};
+
+extern STM32SleepGovernor SleepGovernor;
+
+#endif // _STM32_SLEEP_GOVERNOR_H_
@@ -0,0 +1,66 @@
+/*
+@file   STM32StackMonitor.cpp
+@brief  Stack painting and high-water mark
+*/
+
+#include "STM32StackMonitor.h"
+
+STM32StackMonitor StackMonitor;
+
+// symbols of the linker script
+extern "C" uint32_t _sdata, _ebss, _end, _estack;
+// syscalls of the core, the heap break
+extern "C" void *_sbrk(int incr);
+
+uint32_t *STM32StackMonitor::heapTop() {
+  // word aligned, _sbrk(0) only reads the break
+  uintptr_t top = (uintptr_t)_sbrk(0);
+  return (uint32_t *)((top + 3) & ~(uintptr_t)3);
+}
+
+/*
+  The words up to 32 bytes below the stack pointer are left alone, they are
+  this function's own frame. An interrupt taken while painting lands below
+  the stack pointer as well and is simply counted as stack use.
+*/
+void STM32StackMonitor::paint() {
+  uint32_t *p = heapTop();
+  uint32_t *sp = (uint32_t *)(__get_MSP() - 32);
+  _painted = p;
+  while (p < sp) {
+    *p++ = STACK_MONITOR_PATTERN;
+  }
+}
+
+/*
+  Heap that grew after paint() overwrote the lowest painted words, the scan
+  starts above the current heap top.
+*/
+uint32_t STM32StackMonitor::getHighWater() {
+  if (_painted == nullptr) {
+    return 0;
+  }
+  uint32_t *p = heapTop();
+  if (p < _painted) {
+    p = _painted;
+  }
+  uint32_t *sp = (uint32_t *)__get_MSP();
+  while (p < sp && *p == STACK_MONITOR_PATTERN) {
+    p++;
+  }
+  return (uint32_t)((uintptr_t)&_estack - (uintptr_t)p);
+}
+
+uint32_t STM32StackMonitor::getFree() {
+  uint32_t top = (uint32_t)((uintptr_t)&_estack - (uintptr_t)heapTop());
+  uint32_t used = getHighWater();
+  return (top > used) ? top - used : 0;
+}
+
+uint32_t STM32StackMonitor::getStaticRam() {
+  return (uint32_t)((uintptr_t)&_ebss - (uintptr_t)&_sdata);
+}
+
+uint32_t STM32StackMonitor::getHeap() {
+  return (uint32_t)((uintptr_t)heapTop() - (uintptr_t)&_end);
+}
@@ -0,0 +1,41 @@
+/*
+@file   STM32StackMonitor.h
+@brief  Stack high-water mark by painting. paint() fills the free RAM
+        between the heap and the stack pointer with a pattern, the deepest
+        stack use is the lowest word that no longer holds it.
+
+        RAM layout of the core's linker script, low to high: .data, .bss,
+        heap (grows up from _end), free, stack (grows down from _estack).
+*/
+
+#ifndef _STM32_STACK_MONITOR_H_
+#define _STM32_STACK_MONITOR_H_
+
+#include <Arduino.h>
+
+#define STACK_MONITOR_PATTERN 0xC5C5C5C5UL
+
+class STM32StackMonitor {
+
+public:
+  // call first in setup(), the frames of main() and setup() are used stack
+  void paint();
+
+  // largest stack depth seen since paint(), bytes
+  uint32_t getHighWater();
+  // bytes between the heap top and the deepest stack use, never touched
+  uint32_t getFree();
+  // .data and .bss, bytes
+  uint32_t getStaticRam();
+  // heap taken from sbrk, bytes
+  uint32_t getHeap();
+
+private:
+  uint32_t *heapTop();
+
+  uint32_t *_painted = nullptr; // lowest painted word
+};
+
+extern STM32StackMonitor StackMonitor;
+
+#endif // _STM32_STACK_MONITOR_H_
@@ -0,0 +1,66 @@
+/*
+@file   STM32Timebase.cpp
+@brief  64-bit monotonic millisecond clock on the RTC
+*/
+
+#include "STM32Timebase.h"
+#include "STM32RTC.h"
+
+STM32Timebase Timebase;
+
+/*
+  Starts the RTC when needed and sets the time base to 0 at the current RTC
+  second. Marking the RTC time as set keeps STM32LowPower from setting an
+  arbitrary time later.
+*/
+void STM32Timebase::begin() { setStart(startRTC()); }
+
+// continues a time base that started at startEpoch, e.g. after standby
+void STM32Timebase::begin(uint32_t startEpoch) {
+  startRTC();
+  setStart(startEpoch);
+}
+
+// returns the current epoch
+uint32_t STM32Timebase::startRTC() {
+  STM32RTC &rtc = STM32RTC::getInstance();
+
+  rtc.begin();
+  if (!rtc.isTimeSet()) {
+    rtc.setEpoch(rtc.getEpoch());
+  }
+  return rtc.getEpoch();
+}
+
+void STM32Timebase::setStart(uint32_t startEpoch) {
+  _startEpoch = startEpoch;
+  _offset = -(int64_t)startEpoch * 1000;
+  _last = 0;
+}
+
+/*
+  The RTC calendar can be set backwards (e.g. by calibrateRTC()), the time
+  base then holds its last value and continues from there.
+*/
+uint64_t STM32Timebase::getMillis() {
+  STM32RTC::Snapshot now = STM32RTC::getInstance().getSnapshot();
+  uint64_t t = (uint64_t)now.epoch * 1000 + now.subSeconds + _offset;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  if (t < _last) {
+    _offset += _last - t;
+    t = _last;
+  }
+  _last = t;
+  __set_PRIMASK(primask);
+  return t;
+}
+
+uint32_t STM32Timebase::elapsed_ms(uint64_t since) {
+  uint64_t now = getMillis();
+  if (now <= since) {
+    return 0;
+  }
+  return ((now - since) > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)(now - since);
+}
@@ -0,0 +1,38 @@
+/*
+@file   STM32Timebase.h
+@brief  64-bit monotonic millisecond clock on the RTC. Unlike millis() it
+        keeps counting through idle, sleep and deepSleep, because the RTC
+        runs from the LSI/LSE in stop mode.
+*/
+
+#ifndef _STM32_TIMEBASE_H_
+#define _STM32_TIMEBASE_H_
+
+#include <Arduino.h>
+
+class STM32Timebase {
+
+public:
+  void begin();
+  void begin(uint32_t startEpoch);
+  uint32_t getStartEpoch() { return _startEpoch; }
+
+  // milliseconds since begin(), never decreases
+  uint64_t getMillis();
+  uint32_t getSeconds() { return (uint32_t)(getMillis() / 1000); }
+
+  // milliseconds from since to now, saturates at 0xFFFFFFFF
+  uint32_t elapsed_ms(uint64_t since);
+
+private:
+  uint32_t _startEpoch = 0;
+  int64_t _offset = 0; // added to the RTC time
+  uint64_t _last = 0;  // last returned value
+
+  uint32_t startRTC();
+  void setStart(uint32_t startEpoch);
+};
+
+extern STM32Timebase Timebase;
+
+#endif // _STM32_TIMEBASE_H_
@@ -0,0 +1,118 @@
+/*
+@file   STM32TimerService.cpp
+@brief  Virtual timers on the single RTC alarm
+*/
+
+#include "STM32TimerService.h"
+#include "STM32LowPower.h"
+#include "STM32Timebase.h"
+
+#ifdef USE_SLEEP_GOVERNOR
+#include "STM32SleepGovernor.h"
+#endif
+
+#define NO_DEADLINE 0xFFFFFFFFFFFFFFFFULL
+
+STM32TimerService TimerService;
+
+/*
+  Starts a timer at an absolute deadline, periodic timers are rescheduled
+  on deadline + period so the wakeup time of the job does not add up.
+  Returns the timer id or -1 when all timers are in use.
+*/
+int8_t STM32TimerService::start(uint64_t deadline_ms, uint32_t period_ms,
+                                timerCallback callback, void *data) {
+  if (callback == nullptr) {
+    return -1;
+  }
+  for (int8_t id = 0; id < TIMER_SERVICE_MAX_TIMERS; id++) {
+    if (_timers[id].callback == nullptr) {
+      _timers[id].deadline = deadline_ms;
+      _timers[id].period = period_ms;
+      _timers[id].data = data;
+      _timers[id].callback = callback;
+      return id;
+    }
+  }
+  return -1;
+}
+
+int8_t STM32TimerService::startPeriodic(uint32_t period_ms,
+                                        timerCallback callback, void *data) {
+  return start(Timebase.getMillis() + period_ms, period_ms, callback, data);
+}
+
+void STM32TimerService::stop(int8_t id) {
+  if ((id >= 0) && (id < TIMER_SERVICE_MAX_TIMERS)) {
+    _timers[id].callback = nullptr;
+  }
+}
+
+uint64_t STM32TimerService::getNextDeadline() {
+  uint64_t next = NO_DEADLINE;
+  for (uint8_t id = 0; id < TIMER_SERVICE_MAX_TIMERS; id++) {
+    if ((_timers[id].callback != nullptr) && (_timers[id].deadline < next)) {
+      next = _timers[id].deadline;
+    }
+  }
+  return next;
+}
+
+/*
+  Calls every job that is due or falls due within the merge window and
+  returns the number of calls. A periodic job that missed whole periods
+  runs once and keeps its phase.
+*/
+uint8_t STM32TimerService::run() {
+  uint64_t now = Timebase.getMillis();
+  uint8_t count = 0;
+
+  for (uint8_t id = 0; id < TIMER_SERVICE_MAX_TIMERS; id++) {
+    Timer &timer = _timers[id];
+    if ((timer.callback == nullptr) || (timer.deadline > now + _window)) {
+      continue;
+    }
+    timerCallback callback = timer.callback;
+    void *data = timer.data;
+    if (timer.period == 0) {
+      timer.callback = nullptr;
+    } else {
+      timer.deadline += timer.period;
+      if (timer.deadline <= now) {
+        timer.deadline +=
+            ((now - timer.deadline) / timer.period + 1) * timer.period;
+      }
+    }
+    callback(data);
+    count++;
+  }
+  return count;
+}
+
+/*
+  Sleeps until the earliest deadline, returns right away when a job is due
+  within the merge window. Other wakeup sources end the sleep early.
+*/
+void STM32TimerService::sleep() {
+  uint64_t next = getNextDeadline();
+  if (next == NO_DEADLINE) {
+    return;
+  }
+  uint64_t now = Timebase.getMillis();
+  if (next <= now + _window) {
+    return;
+  }
+  uint64_t delta = next - now;
+  if (delta > 0xFFFFFFFF) {
+    delta = 0xFFFFFFFF;
+  }
+#ifdef USE_SLEEP_GOVERNOR
+  SleepGovernor.sleep((uint32_t)delta);
+#else
+  if (delta < TIMER_SERVICE_MIN_SLEEP) {
+    delay((uint32_t)delta);
+  } else {
+    LowPower.deepSleep((uint32_t)delta);
+  }
+#endif
+}
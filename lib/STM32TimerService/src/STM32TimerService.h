@@ -0,0 +1,55 @@
+/*
+@file   STM32TimerService.h
+@brief  Virtual timers on the single RTC alarm. Jobs register absolute
+        deadlines on the STM32Timebase clock, sleep() programs the alarm for
+        the earliest one and run() calls every job that is due. Jobs that
+        fall due within the merge window share one wakeup.
+*/
+
+#ifndef _STM32_TIMER_SERVICE_H_
+#define _STM32_TIMER_SERVICE_H_
+
+#include <Arduino.h>
+
+#ifndef TIMER_SERVICE_MAX_TIMERS
+#define TIMER_SERVICE_MAX_TIMERS 8
+#endif
+
+// jobs due within this many ms of each other run on the same wakeup
+#define TIMER_SERVICE_MERGE_WINDOW 50
+
+// shorter waits are not worth programming the RTC alarm for
+#define TIMER_SERVICE_MIN_SLEEP 10
+
+typedef void (*timerCallback)(void *data);
+
+class STM32TimerService {
+
+public:
+  int8_t start(uint64_t deadline_ms, uint32_t period_ms,
+               timerCallback callback, void *data = nullptr);
+  int8_t startPeriodic(uint32_t period_ms, timerCallback callback,
+                       void *data = nullptr);
+  void stop(int8_t id);
+
+  void setMergeWindow(uint32_t window_ms) { _window = window_ms; }
+
+  uint64_t getNextDeadline();
+  uint8_t run();
+  void sleep();
+
+private:
+  struct Timer {
+    uint64_t deadline; // absolute, ms on the time base
+    uint32_t period;   // 0 for a one-shot timer
+    timerCallback callback;
+    void *data;
+  };
+
+  Timer _timers[TIMER_SERVICE_MAX_TIMERS];
+  uint32_t _window = TIMER_SERVICE_MERGE_WINDOW;
+};
+
+extern STM32TimerService TimerService;
+
+#endif // _STM32_TIMER_SERVICE_H_
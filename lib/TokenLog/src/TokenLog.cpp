@@ -0,0 +1,97 @@
+/*
+@file   TokenLog.cpp
+@brief  Tokenized deferred logging into a RAM buffer
+*/
+
+#include "TokenLog.h"
+
+TokenLog TokenLogger;
+
+void TokenLog::begin(Print &out) {
+  _out = &out;
+  _head = 0;
+  _count = 0;
+  _dropped = 0;
+}
+
+void TokenLog::start(uint8_t level, uint32_t token, uint8_t count) {
+  _length = 0;
+  _truncated = false;
+  put(TOKEN_LOG_SYNC);
+  put((level << 4) | (count & 0x0F));
+  for (uint8_t i = 0; i < 4; i++) {
+    put(token >> (8 * i));
+  }
+}
+
+// the record is written in place behind the pending ones, commit() makes
+// it pending
+void TokenLog::put(uint8_t b) {
+  if (_count + _length < TOKEN_LOG_BUFFER_SIZE) {
+    _buffer[(_head + _count + _length) % TOKEN_LOG_BUFFER_SIZE] = b;
+    _length++;
+  } else {
+    _truncated = true;
+  }
+}
+
+/*
+  Zigzag maps small negative values to small codes (-1 -> 1, 1 -> 2), the
+  varint then takes 7 bits per byte, so most arguments need one or two bytes
+  instead of the 3 to 11 characters of their text.
+*/
+void TokenLog::argInt(int64_t value) {
+  uint64_t z = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  while (z >= 0x80) {
+    put((uint8_t)z | 0x80);
+    z >>= 7;
+  }
+  put((uint8_t)z);
+}
+
+void TokenLog::arg(const char *text) {
+  size_t n = strlen(text);
+  if (n > 255) {
+    n = 255;
+  }
+  put((uint8_t)n);
+  for (size_t i = 0; i < n; i++) {
+    put(text[i]);
+  }
+}
+
+// a record that does not fit is dropped as a whole, the decoder could not
+// find the next one otherwise
+void TokenLog::commit() {
+  if (_out == nullptr || _truncated) {
+    _dropped++;
+    return;
+  }
+  _count += _length;
+}
+
+void TokenLog::drain() {
+  while (_count > 0) {
+    uint16_t n = _count;
+    if (_head + n > TOKEN_LOG_BUFFER_SIZE) {
+      n = TOKEN_LOG_BUFFER_SIZE - _head;
+    }
+    _out->write(&_buffer[_head], n);
+    _head = (_head + n) % TOKEN_LOG_BUFFER_SIZE;
+    _count -= n;
+  }
+}
+
+void TokenLog::flush() {
+  if (_out == nullptr) {
+    return;
+  }
+  drain();
+  // the loss is reported in the stream, after the records that made it
+  if (_dropped > 0) {
+    uint32_t dropped = _dropped;
+    _dropped = 0;
+    log(LOG_LEVEL_WARN, LOG_TOKEN("[LOG] %lu records dropped"), dropped);
+    drain();
+  }
+}
@@ -0,0 +1,121 @@
+/*
+@file   TokenLog.h
+@brief  Tokenized deferred logging. The format strings stay on the host:
+        a log statement stores a 32-bit FNV-1a hash of its format and the
+        binary arguments in a RAM buffer, which is written to the serial
+        port in one go before the MCU sleeps. scripts/log_tokens.py builds
+        the string table, scripts/log_decode.py renders the records.
+
+        Record: 0xA5, level << 4 | argument count, token (4 bytes, LE),
+        then per argument a zigzag varint, or for %s a length byte and up
+        to 255 characters. Text printed directly to the port passes through the
+        decoder unchanged.
+*/
+
+#ifndef _TOKEN_LOG_H_
+#define _TOKEN_LOG_H_
+
+#include <Arduino.h>
+#include <type_traits>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// statements above this level are not compiled, arguments are not evaluated
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// records waiting for flush(), a record that does not fit is dropped
+#ifndef TOKEN_LOG_BUFFER_SIZE
+#define TOKEN_LOG_BUFFER_SIZE 256
+#endif
+
+#define TOKEN_LOG_SYNC 0xA5
+
+// FNV-1a over the format, must match scripts/log_tokens.py
+constexpr uint32_t logToken(const char *s, uint32_t h = 2166136261UL) {
+  return *s ? logToken(s + 1, (h ^ (uint8_t)*s) * 16777619UL) : h;
+}
+
+// the hash is forced to compile time, the format string is not linked
+#define LOG_TOKEN(fmt) (std::integral_constant<uint32_t, logToken(fmt)>::value)
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...)                                                    \
+  TokenLogger.log(LOG_LEVEL_ERROR, LOG_TOKEN(fmt), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...)                                                     \
+  TokenLogger.log(LOG_LEVEL_WARN, LOG_TOKEN(fmt), ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...)                                                     \
+  TokenLogger.log(LOG_LEVEL_INFO, LOG_TOKEN(fmt), ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...)                                                    \
+  TokenLogger.log(LOG_LEVEL_DEBUG, LOG_TOKEN(fmt), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) ((void)0)
+#endif
+
+class TokenLog {
+
+public:
+  void begin(Print &out);
+
+  template <typename... Args>
+  void log(uint8_t level, uint32_t token, Args... args) {
+    start(level, token, sizeof...(args));
+    int expand[] = {0, (arg(args), 0)...};
+    (void)expand;
+    commit();
+  }
+
+  // write the buffered records to the port, blocks until handed over
+  void flush();
+
+  uint16_t getPending() { return _count; }
+  // records lost since the last flush()
+  uint32_t getDropped() { return _dropped; }
+
+private:
+  void drain();
+  void start(uint8_t level, uint32_t token, uint8_t count);
+  void commit();
+  void put(uint8_t b);
+  void argInt(int64_t value);
+  void arg(const char *text);
+  void arg(char *text) { arg((const char *)text); }
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value ||
+                          std::is_enum<T>::value>::type
+  arg(T value) {
+    argInt((int64_t)value);
+  }
+
+  Print *_out = nullptr;
+  uint8_t _buffer[TOKEN_LOG_BUFFER_SIZE];
+  uint16_t _length; // of the record being written behind the pending ones
+  bool _truncated;
+  uint16_t _head;
+  uint16_t _count;
+  uint32_t _dropped;
+};
+
+extern TokenLog TokenLogger;
+
+#endif // _TOKEN_LOG_H_
@@ -0,0 +1,141 @@
+"""
+@file   check_softfloat.py
+@brief  PlatformIO post-build script: fails the build when an object of the
+        firmware calls the soft-float library, and prints the image size
+        against a recorded baseline.
+
+The Cortex-M0+ has no FPU, every float or double operation is a libgcc call
+(__aeabi_fadd, __aeabi_ddiv, ...). The undefined symbols of each object file
+are listed with nm. RadioLib takes float arguments, so RadioLib, the
+RadioSettings boundary and the framework are allowlisted.
+
+The baseline holds the section sizes, the bytes of soft-float helpers linked
+in and the code size of the functions the fixed point rework touched. Record
+it from a build of the reference commit with
+
+    SOFTFLOAT_BASELINE=save pio run -e transmit
+
+and every later build prints the difference. The cycle counts of these
+functions need the target, the accuracy of the fixed point code against the
+float code is checked by test/test_fixed_point.
+"""
+
+import json
+import os
+import re
+import subprocess
+
+Import("env")  # noqa: F821 (provided by SCons)
+
+# the soft-float helpers of the ARM EABI and the libgcc names behind them
+SOFTFLOAT = re.compile(
+    r"^__(aeabi_[fd]\w*|aeabi_[uil]+2[fd]|aeabi_[fd]2\w+|"
+    r"(add|sub|mul|div|neg|cmp|eq|ne|lt|le|gt|ge|unord)[sd]f\d|"
+    r"(fix|fixuns|float|floatun|extend|trunc)\w*[sd]f\w*)$")
+
+# path components of objects that may use float
+ALLOWLIST = ("FrameworkArduino", "FrameworkCMSIS", "RadioLib", "RadioSettings")
+
+# demangled names of the functions whose size is tracked
+TRACKED = re.compile(
+    r"^(BME280::(compensate|get(Temperature|Pressure|Humidity))\w*|"
+    r"STM32LowPowerCal::(deepSleep|calibrate\w+|lsiCorrectionQ16)|"
+    r"sendPacket)\(")
+
+BASELINE = os.path.join(env.subst("$PROJECT_DIR"),  # noqa: F821
+                        "scripts", "softfloat_baseline.json")
+
+
+def tool(name):
+    # arm-none-eabi-gcc -> arm-none-eabi-nm
+    cc = env.subst("$CC")  # noqa: F821
+    return cc[:-3] + name if cc.endswith("gcc") else name
+
+
+def objects(build_dir):
+    for root, _, files in os.walk(build_dir):
+        for f in files:
+            if f.endswith(".o"):
+                yield os.path.join(root, f)
+
+
+def figures(elf):
+    # text, data and bss of the Berkeley format
+    out = subprocess.run([tool("size"), elf], capture_output=True,
+                         text=True).stdout.splitlines()
+    text, data, bss = (int(v) for v in out[-1].split()[:3])
+    result = {"text": text, "data": data, "bss": bss, "softfloat": 0,
+              "functions": {}}
+    out = subprocess.run([tool("nm"), "-C", "-S", "--defined-only", elf],
+                         capture_output=True, text=True).stdout
+    for line in out.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4 or parts[2].lower() not in "tw":
+            continue
+        size, name = int(parts[1], 16), parts[3]
+        if SOFTFLOAT.match(name):
+            result["softfloat"] += size
+        elif TRACKED.match(name):
+            result["functions"][name] = size
+    return result
+
+
+def report(current):
+    key = env.subst("$PIOENV")  # noqa: F821
+    baseline = {}
+    if os.path.isfile(BASELINE):
+        with open(BASELINE) as f:
+            baseline = json.load(f)
+
+    if os.environ.get("SOFTFLOAT_BASELINE") == "save":
+        baseline[key] = current
+        with open(BASELINE, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+        print("Baseline of %s saved to %s" % (key, BASELINE))
+        return
+    if key not in baseline:
+        print("No baseline of %s, record one with SOFTFLOAT_BASELINE=save"
+              % key)
+        return
+
+    base = baseline[key]
+    print("%-40s %8s %8s %8s" % ("", "baseline", "build", "delta"))
+    for name in ("text", "data", "bss", "softfloat"):
+        print("%-40s %8d %8d %+8d" % (name, base[name], current[name],
+                                       current[name] - base[name]))
+    names = sorted(set(base["functions"]) | set(current["functions"]))
+    for name in names:
+        old = base["functions"].get(name, 0)
+        new = current["functions"].get(name, 0)
+        print("%-40s %8d %8d %+8d" % (name.split("(")[0][:40], old, new,
+                                       new - old))
+
+
+def check_softfloat(source, target, env):
+    build_dir = env.subst("$BUILD_DIR")
+    nm = tool("nm")
+    offenders = {}
+    for obj in objects(build_dir):
+        rel = os.path.relpath(obj, build_dir)
+        if any(part in ALLOWLIST for part in rel.split(os.sep)):
+            continue
+        out = subprocess.run([nm, "-u", obj], capture_output=True,
+                             text=True).stdout
+        calls = sorted({line.split()[-1] for line in out.splitlines()
+                        if line.strip() and
+                        SOFTFLOAT.match(line.split()[-1])})
+        if calls:
+            offenders[rel] = calls
+
+    subprocess.run([tool("size"), str(target[0])])
+    report(figures(str(target[0])))
+
+    if offenders:
+        print("Soft-float calls outside the allowlist:")
+        for rel, calls in sorted(offenders.items()):
+            print("  %s: %s" % (rel, " ".join(calls)))
+        env.Exit(1)
+    print("No soft-float calls outside %s" % ", ".join(ALLOWLIST))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_softfloat)  # noqa: F821
@@ -0,0 +1,106 @@
+"""
+@file   log_decode.py
+@brief  Renders the tokenized log of lib/TokenLog with the string table of
+        scripts/log_tokens.py. Reads a serial port (needs pyserial) or a
+        capture file, plain text on the same port is passed through.
+
+    python scripts/log_decode.py .pio/build/transmit/log_tokens.json COM5
+    python scripts/log_decode.py log_tokens.json capture.bin
+"""
+
+import argparse
+import json
+import re
+import sys
+
+SYNC = 0xA5
+LEVELS = {1: "E", 2: "W", 3: "I", 4: "D"}
+# printf conversions, Python's % takes them without the length modifier
+CONVERSION = re.compile(r"(%[-+ #0]*\d*(?:\.\d+)?)[hlLqjzt]*([diouxXcs%])")
+
+
+def byte_source(name, baud):
+    if name == "-":
+        src = sys.stdin.buffer
+        return iter(lambda: src.read(1), b"")
+    try:
+        f = open(name, "rb")
+        return iter(lambda: f.read(1), b"")
+    except OSError:
+        import serial  # pyserial
+        port = serial.Serial(name, baud)
+        return iter(lambda: port.read(1), b"")
+
+
+def next_byte(stream):
+    return next(stream)[0]
+
+
+def read_varint(stream):
+    shift = 0
+    z = 0
+    while True:
+        b = next_byte(stream)
+        z |= (b & 0x7F) << shift
+        shift += 7
+        if b < 0x80:
+            return (z >> 1) ^ -(z & 1)
+
+
+def read_record(stream, table):
+    head = next_byte(stream)
+    level, count = head >> 4, head & 0x0F
+    token = 0
+    for i in range(4):
+        token |= next_byte(stream) << (8 * i)
+    entry = table.get("0x%08x" % token)
+    if entry is None:
+        return "[?] unknown token 0x%08x, %d arguments" % (token, count)
+    fmt = entry["format"]
+    kinds = [c for _, c in CONVERSION.findall(fmt) if c != "%"]
+    args = []
+    for kind in kinds[:count]:
+        if kind == "s":
+            n = next_byte(stream)
+            args.append(bytes(next_byte(stream) for _ in range(n))
+                        .decode("utf-8", "replace"))
+        else:
+            args.append(read_varint(stream))
+    try:
+        text = CONVERSION.sub(r"\1\2", fmt) % tuple(args)
+    except (TypeError, ValueError):
+        text = "%s %r" % (fmt, args)
+    return "[%s] %s" % (LEVELS.get(level, "?"), text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    parser.add_argument("table", help="log_tokens.json")
+    parser.add_argument("input", help="serial port, capture file or -")
+    parser.add_argument("-b", "--baud", type=int, default=9600)
+    args = parser.parse_args()
+
+    with open(args.table) as f:
+        table = json.load(f)
+    stream = byte_source(args.input, args.baud)
+    text = bytearray()
+    try:
+        while True:
+            b = next_byte(stream)
+            if b == SYNC:
+                if text:
+                    print(text.decode("ascii", "replace").rstrip("\r\n"))
+                    text.clear()
+                print(read_record(stream, table), flush=True)
+            elif b == 0x0A:
+                print(text.decode("ascii", "replace").rstrip("\r"), flush=True)
+                text.clear()
+            else:
+                text.append(b)
+    except (StopIteration, KeyboardInterrupt):
+        if text:
+            print(text.decode("ascii", "replace"))
+
+
+if __name__ == "__main__":
+    main()
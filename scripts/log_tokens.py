@@ -0,0 +1,100 @@
+"""
+@file   log_tokens.py
+@brief  Builds the string table of the tokenized log (lib/TokenLog). Scans
+        the sources for LOG_ERROR/WARN/INFO/DEBUG and LOG_TOKEN statements and
+        writes token -> format as JSON. Fails when two formats share a token.
+
+As a PlatformIO pre script the table goes to $BUILD_DIR/log_tokens.json.
+From the command line:
+    python scripts/log_tokens.py [-o tokens.json] [source dirs ...]
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+# the format with adjacent literals, which the compiler joins
+LITERAL = r'"((?:[^"\\]|\\.)*)"'
+STATEMENT = re.compile(r'\bLOG_(ERROR|WARN|INFO|DEBUG|TOKEN)\s*\(\s*((?:%s\s*)+)'
+                       % LITERAL)
+SOURCES = (".c", ".cpp", ".h", ".hpp")
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "\\": "\\", '"': '"', "'": "'",
+           "0": "\0"}
+
+
+def unescape(text):
+    return re.sub(r"\\(.)", lambda m: ESCAPES.get(m.group(1), m.group(1)),
+                  text)
+
+
+def fnv1a(data):
+    # must match logToken() in TokenLog.h
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def scan(dirs):
+    table = {}
+    for top in dirs:
+        for root, _, files in os.walk(top):
+            for name in sorted(files):
+                if not name.endswith(SOURCES):
+                    continue
+                path = os.path.join(root, name)
+                with open(path, encoding="utf-8", errors="replace") as f:
+                    text = f.read()
+                for m in STATEMENT.finditer(text):
+                    fmt = "".join(unescape(part) for part in
+                                  re.findall(LITERAL, m.group(2)))
+                    token = "0x%08x" % fnv1a(fmt.encode("utf-8"))
+                    line = text.count("\n", 0, m.start()) + 1
+                    entry = table.get(token)
+                    if entry and entry["format"] != fmt:
+                        raise ValueError("token %s of %r (%s:%d) collides with "
+                                         "%r (%s:%d)" % (
+                                             token, fmt, path, line,
+                                             entry["format"], entry["file"],
+                                             entry["line"]))
+                    if not entry:
+                        table[token] = {"format": fmt, "file": path,
+                                        "line": line}
+    return table
+
+
+def write(table, out):
+    os.makedirs(os.path.dirname(os.path.abspath(out)), exist_ok=True)
+    with open(out, "w") as f:
+        json.dump(table, f, indent=1, sort_keys=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    parser.add_argument("-o", "--output", default="log_tokens.json")
+    parser.add_argument("dirs", nargs="*", default=["src", "lib"])
+    args = parser.parse_args()
+    try:
+        table = scan(args.dirs)
+    except ValueError as e:
+        sys.exit(str(e))
+    write(table, args.output)
+    print("%d log formats -> %s" % (len(table), args.output))
+
+
+try:
+    Import("env")  # noqa: F821 (provided by SCons)
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    project = env.subst("$PROJECT_DIR")  # noqa: F821
+    out = os.path.join(env.subst("$BUILD_DIR"), "log_tokens.json")  # noqa: F821
+    try:
+        write(scan([os.path.join(project, "src"),
+                    os.path.join(project, "lib")]), out)
+    except ValueError as e:
+        print(e)
+        env.Exit(1)  # noqa: F821
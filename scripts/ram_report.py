@@ -0,0 +1,136 @@
+"""
+@file   ram_report.py
+@brief  Static RAM per subsystem from the linker map: .data, .bss and COMMON
+        input sections in RAM, summed by library. Also the RAM left for heap
+        and stack, and with --stack the headroom left by a measured stack
+        high-water mark and heap (the "stk" and "heap" fields of the
+        diagnostics uplink).
+
+As a PlatformIO post script it links with -Wl,-Map and prints the report
+after every build. From the command line:
+    python scripts/ram_report.py .pio/build/transmit/firmware.map \
+        [--stack N] [--heap N]
+"""
+
+import argparse
+import os
+import re
+import sys
+
+MEMORY = re.compile(r"^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+# " .bss.name  0xADDR  0xSIZE  object" on one line or with the name alone
+SECTION = re.compile(r"^ (\.data\S*|\.bss\S*|COMMON|\.noinit\S*|\*fill\*)"
+                     r"(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*(.*))?$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+LIBRARY = re.compile(r"lib([^/\\]+)\.a\(")
+
+
+def subsystem(obj):
+    if not obj:
+        return "fill"
+    m = LIBRARY.search(obj)
+    if m:
+        name = m.group(1)
+        if name.startswith("Framework"):
+            return "core"
+        if name in ("c", "c_nano", "g", "g_nano", "gcc", "m", "nosys",
+                    "stdc++", "stdc++_nano", "supc++", "supc++_nano"):
+            return "libc"
+        return name
+    parts = re.split(r"[/\\]", obj)
+    if "src" in parts:
+        return "app"
+    if any(p.startswith("Framework") for p in parts):
+        return "core"
+    return os.path.basename(obj)
+
+
+def parse(path):
+    ram = None
+    usage = {}
+    pending = None
+    in_memory = in_map = False
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if line.startswith("Memory Configuration"):
+                in_memory = True
+                continue
+            if line.startswith("Linker script and memory map"):
+                in_memory = False
+                in_map = True
+                continue
+            if in_memory:
+                m = MEMORY.match(line)
+                if m and m.group(1) == "RAM":
+                    ram = (int(m.group(2), 16), int(m.group(3), 16))
+                continue
+            if not in_map or ram is None:
+                continue
+            if pending:
+                m = CONTINUATION.match(line)
+                if m:
+                    add(usage, ram, int(m.group(1), 16), int(m.group(2), 16),
+                        m.group(3))
+                pending = None
+                continue
+            m = SECTION.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)
+            else:
+                add(usage, ram, int(m.group(2), 16), int(m.group(3), 16),
+                    m.group(4).strip())
+    if ram is None:
+        raise ValueError("no RAM region in " + path)
+    return ram, usage
+
+
+def add(usage, ram, address, size, obj):
+    origin, length = ram
+    if size and origin <= address < origin + length:
+        key = subsystem(obj)
+        usage[key] = usage.get(key, 0) + size
+
+
+def report(path, stack=None, heap=0, out=sys.stdout):
+    (origin, length), usage = parse(path)
+    static = sum(usage.values())
+    out.write("RAM %d bytes at 0x%08x\n" % (length, origin))
+    for name, size in sorted(usage.items(), key=lambda kv: -kv[1]):
+        out.write("  %-24s %6d  %5.1f%%\n" % (name, size, 100.0 * size / length))
+    out.write("  %-24s %6d  %5.1f%%\n" % ("static total", static,
+                                          100.0 * static / length))
+    out.write("  %-24s %6d\n" % ("heap + stack", length - static))
+    if stack is not None:
+        out.write("  %-24s %6d\n" % ("heap", heap))
+        out.write("  %-24s %6d\n" % ("stack high-water", stack))
+        out.write("  %-24s %6d\n" % ("headroom",
+                                      length - static - heap - stack))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[2])
+    parser.add_argument("map", help="linker map file")
+    parser.add_argument("--stack", type=int,
+                        help="measured stack high-water mark in bytes")
+    parser.add_argument("--heap", type=int, default=0,
+                        help="heap taken from sbrk in bytes")
+    args = parser.parse_args()
+    try:
+        report(args.map, args.stack, args.heap)
+    except (OSError, ValueError) as e:
+        sys.exit(str(e))
+
+
+try:
+    Import("env")  # noqa: F821 (provided by SCons)
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    MAP = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")  # noqa: F821
+    env.Append(LINKFLAGS=["-Wl,-Map," + MAP])  # noqa: F821
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf",  # noqa: F821
+                      lambda source, target, env: report(MAP))
@@ -33,27 +33,238 @@ Source: https://www.iot-lab.org/blog/370/
 #define RST PA9
 #define DIO1 PB4
 
+#ifdef USE_BUS_TRACE
+#include "BusTrace.h"
+
+// SPI clock used by RadioLib for the SX1276
+#define RADIO_SPI_CLOCK 2000000
+
+// RadioLib HAL that logs every chip-select session of the radio. RadioLib
+// transfers address and data in one spiTransfer() call, bit 7 of the
+// address selects a write.
+class TracingHal : public ArduinoHal {
+public:
+  TracingHal(SPIClass &spi)
+      : ArduinoHal(spi, SPISettings(RADIO_SPI_CLOCK, MSBFIRST, SPI_MODE0)) {}
+
+  void spiTransfer(uint8_t *out, size_t len, uint8_t *in) override {
+    ArduinoHal::spiTransfer(out, len, in);
+    if (len > 0) {
+      BusTracer.record(NSS_RADIO, out[0] & 0x7F,
+                       (out[0] & 0x80) ? BusTrace::BUS_WRITE
+                                       : BusTrace::BUS_READ,
+                       len - 1, RADIO_SPI_CLOCK);
+    }
+  }
+};
+
+TracingHal radioHal(SPI);
+SX1276 radio = new Module(&radioHal, NSS_RADIO, DIO0, RST, DIO1);
+#else
 SX1276 radio = new Module(NSS_RADIO, DIO0, RST, DIO1);
+#endif
+
+#include "RadioSettings.h"
+#include "PayloadWriter.h"
+
+// JSON payload of one packet, the longest is 94 bytes with a 15 character
+// node name, the diagnostics uplink up to 255
+#if defined(USE_ENERGY_METER) || defined(USE_STACK_MONITOR)
+#define PAYLOAD_SIZE 256
+#else
+#define PAYLOAD_SIZE 128
+#endif
+
+#ifdef USE_HEAP_GUARD
+#include "STM32HeapGuard.h"
+#endif
+
+/* LoRa settings shared by the transmit and receive node */
+const RadioSettings radioDefaults = {
+    915000,                    // frequency in kHz
+    1250,                      // bandwidth in 100 Hz
+    9,                         // spreading factor
+    7,                         // coding rate 4/7
+    RADIOLIB_SX127X_SYNC_WORD, // sync word
+    17,                        // output power in dBm
+    8,                         // preamble length
+    0                          // automatic gain control
+};
+
+#ifdef USE_CONFIG_STORE
+#include "STM32ConfigStore.h"
+
+/* keys of the tunables in the configuration store, never reuse a number */
+enum ConfigKey : uint8_t {
+  CONFIG_SLEEP_INTERVAL = 1,         // ms
+  CONFIG_RADIO_FREQUENCY = 2,        // kHz
+  CONFIG_RADIO_BANDWIDTH = 3,        // 100 Hz
+  CONFIG_RADIO_SPREADING_FACTOR = 4, // 6 .. 12
+  CONFIG_RADIO_CODING_RATE = 5,      // 5 .. 8
+  CONFIG_RADIO_POWER = 6,            // dBm
+  CONFIG_CAL_TIME_DIVIDER = 7,       // ms
+  CONFIG_CLIENT_ID = 8,              // up to 8 characters
+  CONFIG_LATENCY_IDLE = 9,           // us, measured by the sleep governor
+  CONFIG_LATENCY_SLEEP = 10,         // us
+  CONFIG_LATENCY_DEEP_SLEEP = 11,    // us
+  CONFIG_LATENCY_BUILD = 12          // crc32 of BUILD_STAMP of the measuring build
+};
+#endif
+
+/* radioDefaults with the per site values from the configuration store */
+RadioSettings radioConfig() {
+  RadioSettings settings = radioDefaults;
+#ifdef USE_CONFIG_STORE
+  settings.frequency_kHz =
+      ConfigStore.getU32(CONFIG_RADIO_FREQUENCY, settings.frequency_kHz);
+  settings.bandwidth_100Hz =
+      ConfigStore.getU32(CONFIG_RADIO_BANDWIDTH, settings.bandwidth_100Hz);
+  settings.spreadingFactor = ConfigStore.getU32(CONFIG_RADIO_SPREADING_FACTOR,
+                                                settings.spreadingFactor);
+  settings.codingRate =
+      ConfigStore.getU32(CONFIG_RADIO_CODING_RATE, settings.codingRate);
+  settings.power = ConfigStore.getI32(CONFIG_RADIO_POWER, settings.power);
+#endif
+  return settings;
+}
+
+int radioBegin(const RadioSettings &settings) {
+  return beginSX127x(radio, settings);
+}
 
 #ifdef DEBUG_MAIN
+#ifdef USE_DMA_UART
+// USART2 transmit through DMA, printing only copies into its ring buffer
+#include "STM32DebugUart.h"
+#define DEBUG_PORT DebugUart
+#else
 // Redirect debug output to Serial2 (Tx on PA2)
 HardwareSerial Serial2(USART2); // or HardwareSerial Serial2(PA3, PA2)
-#define DEBUG_BEGIN(...) Serial2.begin(__VA_ARGS__)
-#define DEBUG_PRINT(...) Serial2.print(__VA_ARGS__)
-#define DEBUG_PRINTLN(...) Serial2.println(__VA_ARGS__)
+#define DEBUG_PORT Serial2
+#endif
+#define DEBUG_BEGIN(...) DEBUG_PORT.begin(__VA_ARGS__)
+#define DEBUG_PRINT(...) DEBUG_PORT.print(__VA_ARGS__)
+#define DEBUG_PRINTLN(...) DEBUG_PORT.println(__VA_ARGS__)
 #else
 #define DEBUG_BEGIN(...)
 #define DEBUG_PRINT(...)
 #define DEBUG_PRINTLN(...)
 #endif
 
+// The DMA and USART stop with the clocks in stop mode. The "serial" power
+// hook drains the ring before it, without the hooks the sleep paths do.
+#if defined(DEBUG_MAIN) && defined(USE_DMA_UART) && !defined(USE_POWER_HOOKS)
+#define DEBUG_PREPARE_SLEEP() DebugUart.prepareSleep()
+#else
+#define DEBUG_PREPARE_SLEEP()
+#endif
+
+// Tokenized log of the transmit node, scripts/log_decode.py renders it on
+// the host. Without DEBUG_MAIN every level compiles out.
+#ifndef DEBUG_MAIN
+#undef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_NONE
+#endif
+#include "TokenLog.h"
+
+#if defined(USE_BOOT_CACHE) || \
+    (defined(USE_CONFIG_STORE) && defined(USE_SLEEP_GOVERNOR))
+#include "STM32DataEEPROM.h"
+
+// identifies the firmware build in the boot cache and the measurements in
+// the configuration store, changes whenever the main file is rebuilt
+#define BUILD_STAMP __DATE__ " " __TIME__
+#endif
+
+#ifdef USE_BOOT_CACHE
+#include "STM32BootCache.h"
+#endif
+
+#ifdef USE_TIMEBASE
+#include "STM32Timebase.h"
+#endif
+
+#ifdef USE_SLEEP_GOVERNOR
+#if !defined(USE_TIMEBASE) || !defined(USE_LOW_POWER)
+#error "USE_SLEEP_GOVERNOR needs USE_TIMEBASE and USE_LOW_POWER"
+#endif
+#include "STM32SleepGovernor.h"
+#endif
+
+#ifdef USE_TIMER_SERVICE
+#if !defined(USE_TIMEBASE) || !defined(USE_LOW_POWER)
+#error "USE_TIMER_SERVICE needs USE_TIMEBASE and USE_LOW_POWER"
+#endif
+#include "STM32TimerService.h"
+
+#ifdef USE_LOW_POWER_CAL
+// the LSI correction runs as its own job, a multiple of the sample interval
+// so it shares a wakeup with a sample job in the merge window
+#define RTC_CORRECTION_INTERVAL 600000
+#endif
+#endif
+
+#ifdef USE_CLOCK_PROFILES
+#include "STM32ClockManager.h"
+#endif
+
+#ifdef USE_STANDBY
+#if !defined(USE_LOW_POWER) || defined(USE_BME_STREAMING) ||                   \
+    defined(USE_TIMER_SERVICE) || defined(USE_RTC_PERIODIC_WAKEUP)
+#error "USE_STANDBY needs USE_LOW_POWER and the plain sleep interval loop"
+#endif
+#include "STM32Retention.h"
+#endif
+
+#ifdef USE_POWER_HOOKS
+#ifndef USE_LOW_POWER
+#error "USE_POWER_HOOKS needs USE_LOW_POWER"
+#endif
+#include "STM32PowerHooks.h"
+#endif
+
+#ifdef USE_ENERGY_METER
+#ifdef USE_STANDBY
+#error "USE_ENERGY_METER keeps its counters in RAM, standby loses them"
+#endif
+#include "EnergyMeter.h"
+
+// for the projected battery life, 2 x AA
+#define BATTERY_CAPACITY_MAH 2500
+#endif
+
+#ifdef USE_STACK_MONITOR
+#include "STM32StackMonitor.h"
+#endif
+
+// the energy and RAM figures go out in a diagnostics packet after every
+// DIAG_INTERVAL packets
+#if defined(USE_ENERGY_METER) || defined(USE_STACK_MONITOR)
+#define USE_DIAGNOSTICS
+#define DIAG_INTERVAL 60
+#endif
+
+#if defined(USE_LSI_DRIFT_MODEL) && !defined(USE_LOW_POWER_CAL)
+#error "USE_LSI_DRIFT_MODEL needs USE_LOW_POWER_CAL"
+#endif
+
 #ifdef USE_LOW_POWER_CAL
 #include "STM32LowPowerCal.h"
 
-const double calTimeDivider = 7980.0;
+const uint32_t calTimeDivider = 7980; // ms
 #endif
 
 // Sleep this many microseconds. Notice that the sending and waiting for
 // downlink will extend the time between send packets. You have to extract this
 // time
-#define SLEEP_INTERVAL 10000
\ No newline at end of file
+#define SLEEP_INTERVAL 10000
+
+// Node name in the JSON payload
+#define CLIENT_ID "NS001"
+
+// Sample interval in milliseconds of the normal mode streaming, every
+// BME280_STREAM_DECIMATION samples are sent as one packet
+#define STREAM_INTERVAL 1000
+
+// MCU run current at 32 MHz in uA, used for the energy estimates
+#define MCU_RUN_CURRENT_UA 6400
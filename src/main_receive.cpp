@@ -6,6 +6,9 @@
  *
  * Changelog:
  *
+ * [2026-10-18]
+ * - Packets are read into a static buffer instead of String.
+ *
  * [2025-08-08]
  * - Implemented SX127x_Receive_Interrupt.ino from RadioLib library.
  *
@@ -19,6 +22,9 @@
 // flag to indicate that a packet was received
 volatile bool received_flag = false;
 
+// received packet, static so the loop does not touch the heap
+uint8_t packet[RADIOLIB_SX127X_MAX_PACKET_LENGTH + 1];
+
 void set_flag(void) {
   // we got a packet, set the flag
   received_flag = true;
@@ -30,6 +36,10 @@ void setup() {
 
   pinMode(NSS_RADIO, OUTPUT);
 
+#ifdef USE_CONFIG_STORE
+  ConfigStore.begin();
+#endif
+
   /* Time for serial settings */
   delay(1000);
 
@@ -41,11 +51,16 @@ void setup() {
   // calibrate the RTC times with the HSI internal clock
   // time calibration on device with correct timing (ideal 8000.00)
   // incease this time to shorten time between send and receive
+#ifdef USE_CONFIG_STORE
+  LowPowerCal.setRTCCalibrationTime(
+      ConfigStore.getU32(CONFIG_CAL_TIME_DIVIDER, calTimeDivider));
+#else
   LowPowerCal.setRTCCalibrationTime(calTimeDivider);
+#endif
   // callibrate for 8 seconds
   LowPowerCal.calibrateRTC();
-  DEBUG_PRINT("RTC Time Correction: ");
-  DEBUG_PRINTLN(LowPowerCal.getRTCTimeCorrection(), 5);
+  DEBUG_PRINT("RTC Time Correction ppm: ");
+  DEBUG_PRINTLN(LowPowerCal.getRTCTimeCorrection_ppm());
 #endif
 
   // initialize SX1278 with default settings
@@ -53,8 +68,7 @@ void setup() {
   DEBUG_PRINTLN(F("[RFM95/SX1276] Initializing ... "));
 #endif
   digitalWrite(NSS_RADIO, LOW); // Enable RFM95
-  int state =
-      radio.begin(915.0, 125.0, 9, 7, RADIOLIB_SX127X_SYNC_WORD, 17, 8, 0);
+  int state = radioBegin(radioConfig());
   if (state == RADIOLIB_ERR_NONE) {
 #ifdef DEBUG_MAIN
     DEBUG_PRINTLN("[RFM95/SX1276] Initialized");
@@ -93,6 +107,10 @@ void setup() {
 #ifdef USE_LOW_POWER
   LowPower.begin();
 #endif
+
+#ifdef USE_HEAP_GUARD
+  HeapGuard.lock();
+#endif
 }
 
 void loop() {
@@ -106,21 +124,20 @@ void loop() {
     DEBUG_PRINT("[RFM95/SX1276] Waiting for incoming transmission ... ");
 #endif
 
-    // you can receive data as an Arduino String
-    // NOTE: receive() is a blocking method!
-    //       See example ReceiveInterrupt for details
-    //       on non-blocking reception method.
-    String str;
+    // read into the static buffer, the String overload of readData()
+    // allocates on every packet
     digitalWrite(NSS_RADIO, LOW);
-    int state = radio.readData(str);
+    size_t length = radio.getPacketLength();
+    int state = radio.readData(packet, length);
     digitalWrite(NSS_RADIO, HIGH);
+    packet[length] = '\0';
 
     if (state == RADIOLIB_ERR_NONE) {
       // packet was successfully received
       DEBUG_PRINTLN("SUCCESS!");
       // print the data of the packet
       DEBUG_PRINT("[RFM95/SX1276] Data:\t\t\t");
-      DEBUG_PRINTLN(str);
+      DEBUG_PRINTLN((const char *)packet);
 
       // print the RSSI (Received Signal Strength Indicator)
       DEBUG_PRINT("[RFM95/SX1276] RSSI:\t\t\t");
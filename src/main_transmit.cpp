@@ -12,6 +12,54 @@
  *
  * Changelog:
  *
+ * [2026-10-18]
+ * - Added the SPI bus trace (USE_BUS_TRACE) with a per-cycle traffic budget,
+ *   checked on the host by test/test_bus_trace.
+ * - Added noise driven BME280 oversampling (USE_ADAPTIVE_OVERSAMPLING).
+ * - Added normal mode streaming with decimation (USE_BME_STREAMING), the
+ *   forced/normal energy comparison is in test/test_stream_energy.
+ * - Added the warm boot record in data EEPROM (USE_BOOT_CACHE), a power-on
+ *   reset always boots cold.
+ * - Added the wear-leveled configuration store for the tunables
+ *   (USE_CONFIG_STORE), checked on the host by test/test_config_store.
+ * - Added the periodic RTC wakeup timer (USE_RTC_PERIODIC_WAKEUP).
+ * - Added the monotonic RTC time base across stop mode (USE_TIMEBASE).
+ * - Added the virtual timer service on the RTC alarm (USE_TIMER_SERVICE),
+ *   the LSI correction is a job of its own next to the sample job.
+ * - Added the sleep mode governor for the timer service (USE_SLEEP_GOVERNOR),
+ *   the measured mode latencies are stored per build.
+ * - Removed the fixed 10 ms delay after stop mode, added the wake latency
+ *   report (USE_WAKEUP_LATENCY).
+ * - Added the clock profile manager, wakeups run at MSI 2 MHz with the HSI
+ *   off, the debug port drains before every switch (USE_CLOCK_PROFILES).
+ * - Added suspend/resume hooks around the low power modes, unused bus pins
+ *   go to analog (USE_POWER_HOOKS).
+ * - Added a packet sequence number ("seq") to the payload.
+ * - Added the standby duty cycle with the state retained in the RTC backup
+ *   registers (USE_STANDBY).
+ * - The RTC calibration measures the LSI with TIM21 input capture in a few
+ *   ms instead of comparing 8 seconds against SysTick, checked on the host
+ *   by test/test_lsi_cal.
+ * - The RTC correction goes into the RTC prescalers and smooth calibration.
+ * - Added the temperature model of the LSI drift (USE_LSI_DRIFT_MODEL),
+ *   checked on the host by test/test_lsi_drift.
+ * - The payload is formatted into a static buffer instead of String, added
+ *   the heap allocation guard (USE_HEAP_GUARD).
+ * - VCC and the MCU temperature come from one oversampled ADC scan that
+ *   powers the ADC down afterwards.
+ * - The debug output is a tokenized binary log (lib/TokenLog), decode it
+ *   with scripts/log_decode.py and the table of scripts/log_tokens.py.
+ * - Added the DMA driven debug UART with a ring buffer (USE_DMA_UART).
+ * - Added the per-phase energy accounting with a diagnostics uplink every
+ *   DIAG_INTERVAL packets (USE_ENERGY_METER).
+ * - Added the stack high-water mark and RAM figures to the diagnostics
+ *   uplink (USE_STACK_MONITOR), scripts/ram_report.py for the static RAM
+ *   per library.
+ * - Removed the soft-float code outside RadioLib: fixed point BME280 results
+ *   and RTC correction, checked after each build by
+ *   scripts/check_softfloat.py against a size baseline and on the host
+ *   against the float code by test/test_fixed_point.
+ *
  * [2025-09-02]
  * - Try to reduce FLASH size (please see the main.h)
  *
@@ -55,89 +103,638 @@
 /* A BME280 object using SPI, chip select pin PA1 */
 BME280 bme(SPI, NSS_BME);
 
+#ifdef USE_ADAPTIVE_OVERSAMPLING
+#include "AdaptiveOversampling.h"
+
+/* steps the oversampling of each channel to hold the target noise */
+AdaptiveOversampling oversampling(bme);
+#endif
+
+#ifdef USE_BME_STREAMING
+#include "BME280Stream.h"
+
+/* free running BME280, decimated on the MCU */
+BME280Stream bmeStream(bme);
+#endif
+
+#ifdef USE_LSI_DRIFT_MODEL
+#include "LsiDriftModel.h"
+
+/* LSI correction over temperature, from occasional short calibrations */
+LsiDriftModel lsiDrift;
+
+#ifdef USE_TIMER_SERVICE
+// BME280 temperature of the last sample for the correction job, 0.01 degC
+int32_t correction_temperature = INT32_MIN;
+#endif
+#endif
+
 // save transmission state between loops
 int transmission_state = RADIOLIB_ERR_NONE;
 
 // flag to indicate that a packet was sent
 volatile bool transmitted_flag = true;
 
+// send the first packet without sleeping first (warm boot)
+bool skip_sleep = false;
+
+// packet counter, kept across standby
+uint32_t packet_seq = 0;
+
+// tunables, overridden from the configuration store in setup()
+uint32_t sleep_interval = SLEEP_INTERVAL;
+char client_id[16] = CLIENT_ID;
+
+// packet text, static so the sample loop does not touch the heap
+char payload[PAYLOAD_SIZE];
+
+#ifdef USE_ENERGY_METER
+/* time and modelled charge per phase of the duty cycle */
+EnergyMeter energy;
+#endif
+
+#ifdef USE_DIAGNOSTICS
+// packets until the next diagnostics uplink
+uint32_t diag_countdown = DIAG_INTERVAL;
+#endif
+
 void set_flag(void) {
   // we sent a packet, set the flag
   transmitted_flag = true;
 }
 
-bool initializeBME280() {
+#ifdef USE_CLOCK_PROFILES
+// text still shifting out would change its baud rate mid byte
+void clockChanging(uint32_t hz) {
+  (void)hz;
+#ifdef DEBUG_MAIN
+  TokenLogger.flush();
+  DEBUG_PORT.flush();
+#endif
+}
+
+// baud rate and SPI prescaler follow the new bus clock
+void clockChanged(uint32_t hz) {
+  (void)hz;
+#ifdef DEBUG_MAIN
+  DEBUG_BEGIN(9600);
+#endif
+  SPI.end();
+  SPI.begin();
+}
+#endif
+
+#ifdef USE_POWER_HOOKS
+// both SPI slaves release MISO while deselected, SCK and MOSI stay driven so
+// the slave inputs do not float
+void busSuspend(LP_Mode mode) {
+  (void)mode;
+  __HAL_RCC_SPI1_CLK_DISABLE();
+}
+
+void busResume(LP_Mode mode) {
+  (void)mode;
+  __HAL_RCC_SPI1_CLK_ENABLE();
+}
+
+// IntRef.sample() switches the ADC off itself, analogRead() leaves the
+// clock and the VREFINT buffer on
+void intRefSuspend(LP_Mode mode) {
+  (void)mode;
+  CLEAR_BIT(ADC->CCR, ADC_CCR_VREFEN | ADC_CCR_TSEN);
+  __HAL_RCC_ADC1_CLK_DISABLE();
+}
+
+#ifdef DEBUG_MAIN
+void serialSuspend(LP_Mode mode) {
+  (void)mode;
+  TokenLogger.flush();
+#ifdef USE_DMA_UART
+  DebugUart.prepareSleep();
+#else
+  Serial2.flush();
+#endif
+}
+#endif
+#endif
+
+bool initializeBME280(bool warm_boot) {
 
   /* set forced mode to control the NSS pin */
   bme.setForcedMode();
 
-  if (bme.begin() < 0) {
-#ifdef DEBUG_MAIN
-    DEBUG_PRINTLN(
-        "Error communicating with BME280 sensor, please check wiring");
+#ifdef USE_BOOT_CACHE
+  if (warm_boot && (bme.beginWithTrimming(BootCache.trimming) > 0)) {
+    LOG_INFO("[BME280] Initialized from boot cache");
+    return true;
+  }
+#else
+  (void)warm_boot;
 #endif
+
+  if (bme.begin() < 0) {
+    LOG_ERROR("Error communicating with BME280 sensor, please check wiring");
     return false;
   }
+  LOG_INFO("[BME280] Initialized");
+  return true;
+}
+
+// report the finished transmission and power down the transmitter
+void finishTransmission() {
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_RADIO_FINISH);
+#endif
+#ifdef USE_BUS_TRACE
+  // the finished cycle ends with the transmit done interrupt
+  if (BusTracer.overBudget()) {
+    LOG_WARN("[BUS] traffic over budget");
 #ifdef DEBUG_MAIN
-  DEBUG_PRINTLN("[BME280] Initialized ");
+    TokenLogger.flush();
+    BusTracer.printReport(DEBUG_PORT);
+#endif
+  }
+  BusTracer.reset();
+#endif
+
+  if (transmission_state == RADIOLIB_ERR_NONE) {
+    // packet was successfully sent
+    LOG_INFO("PACKET SUCCESSFULLY TRANSMITTED!");
+
+    // NOTE: when using interrupt-driven transmit method,
+    //       it is not possible to automatically measure
+    //       transmission data rate using getDataRate()
+
+  } else {
+    LOG_ERROR("failed, code %d", transmission_state);
+  }
+
+  // clean up after transmission is finished
+  // this will ensure transmitter is disabled,
+  // RF switch is powered down etc.
+  radio.finishTransmit();
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_SLEEP_ENTRY);
+#endif
+}
+
+#ifdef USE_STANDBY
+// standby resets the MCU on the RTC alarm, setup() continues from the
+// retained state
+void enterStandby() {
+  Retention.sequence = packet_seq;
+#ifdef USE_LOW_POWER_CAL
+  Retention.rtcCorrectionQ16 = LowPowerCal.getRTCTimeCorrectionQ16();
+#else
+  Retention.rtcCorrectionQ16 = 1UL << 16;
+#endif
+#ifdef USE_TIMEBASE
+  Retention.timebaseEpoch = Timebase.getStartEpoch();
+#else
+  Retention.timebaseEpoch = 0;
+#endif
+  Retention.save();
+
+  digitalWrite(NSS_RADIO, LOW);
+  radio.sleep();
+  digitalWrite(NSS_RADIO, HIGH);
+  DEBUG_PREPARE_SLEEP();
+  LowPower.shutdown(sleep_interval);
+}
+#endif
+
+// wait before transmitting again
+void waitForNextSample() {
+  if (skip_sleep) {
+    skip_sleep = false;
+  } else {
+#ifdef USE_ENERGY_METER
+    // micros() stops in stop mode, the sleep is timed on the RTC
+    energy.suspend();
+#ifdef USE_TIMEBASE
+    uint64_t sleep_start = Timebase.getMillis();
+#endif
+#endif
+#if defined(USE_BME_STREAMING)
+    // read the free running BME280 on every tick until a decimation window
+    // is complete
+    do {
+      DEBUG_PREPARE_SLEEP();
+#if defined(USE_RTC_PERIODIC_WAKEUP)
+      LowPower.deepSleep();
+#elif defined(USE_LOW_POWER)
+      LowPower.deepSleep(STREAM_INTERVAL);
+#else
+      delay(STREAM_INTERVAL);
+#endif
+      bmeStream.poll();
+    } while (!bmeStream.ready());
+#elif defined(USE_RTC_PERIODIC_WAKEUP)
+    DEBUG_PREPARE_SLEEP();
+    LowPower.deepSleep();
+#elif defined(USE_STANDBY)
+    enterStandby();
+#elif defined(USE_LOW_POWER)
+    DEBUG_PREPARE_SLEEP();
+    LowPower.deepSleep(sleep_interval);
+#else
+    delay(sleep_interval);
+#endif
+#ifdef USE_ENERGY_METER
+#ifdef USE_TIMEBASE
+    energy.addSleep_ms(Timebase.elapsed_ms(sleep_start));
+#else
+    energy.addSleep_ms(sleep_interval);
+#endif
+#endif
+  }
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_WAKE);
+#endif
+}
+
+#ifdef USE_LSI_DRIFT_MODEL
+// follow the LSI drift with the BME280 temperature, a TIM21 calibration
+// only runs when the model has no point near the temperature
+void updateRTCCorrection(int32_t temperature) {
+  if (lsiDrift.needsCalibration(temperature) && LowPowerCal.calibrateLSI()) {
+    lsiDrift.add(temperature, LowPowerCal.getRTCTimeCorrectionQ16());
+    LOG_INFO("[RTC] LSI calibrated, points %u slope ppm/degC %d",
+             lsiDrift.getCount(), lsiDrift.getSlope_ppm());
+  } else {
+    LowPowerCal.setRTCTimeCorrectionQ16(lsiDrift.predict(temperature));
+  }
+  LowPowerCal.applyRTCCalibration();
+}
+#endif
+
+// read the sensors and send another packet
+void sendPacket() {
+#ifdef USE_CLOCK_PROFILES
+  // payload formatting and the radio SPI run at 16 MHz, the rest of the
+  // wakeup at the base profile
+  ClockScope clock(CLOCK_HSI16);
+#endif
+  LOG_INFO("[SX1278] Sending another packet ... ");
+#ifdef USE_TIMEBASE
+  LOG_DEBUG("[TIME] ms since boot: %llu", Timebase.getMillis());
 #endif
+#if defined(USE_WAKEUP_LATENCY) && defined(USE_LOW_POWER)
+  LOG_DEBUG("[SLEEP] wake latency us: %lu max %lu",
+            LowPower.getWakeupLatency(), LowPower.getWakeupLatency(true));
+#endif
+#if defined(DEBUG_MAIN) && defined(USE_DMA_UART)
+  static uint32_t reported_overruns = 0;
+  if (DebugUart.getOverruns() != reported_overruns) {
+    reported_overruns = DebugUart.getOverruns();
+    LOG_WARN("[UART] dropped %lu bytes in %lu overruns, fill max %u",
+             DebugUart.getDropped(), DebugUart.getOverruns(),
+             DebugUart.getHighWater());
+  }
+#endif
+#if defined(DEBUG_MAIN) &&                                                     \
+    (defined(USE_POWER_HOOKS) || defined(USE_HEAP_GUARD))
+  // the text reports go out after the pending records
+  TokenLogger.flush();
+#ifdef USE_POWER_HOOKS
+  PowerHooks.report(DEBUG_PORT);
+#endif
+#ifdef USE_HEAP_GUARD
+  HeapGuard.report(DEBUG_PORT);
+#endif
+#endif
+
+  // Prepare upstream data transmission at the next possible time.
+  // one ADC scan of VREFINT and the internal sensor, the ADC is off after
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_ADC);
+#endif
+  IntRefSample adc = {};
+  IntRef.sample(adc);
+  int32_t vcc = adc.vdda_mV;
+
+  // 0.01 degC, Pa and 0.01 %RH
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_SENSOR);
+#endif
+  int32_t temperature, pressure, humidity;
+#ifdef USE_BME_STREAMING
+  bmeStream.getMean(&temperature, &pressure, &humidity);
+#else
+  // reading data from BME sensor
+  digitalWrite(NSS_RADIO, HIGH);
+  bme.readSensor();
+  temperature = bme.getTemperature_cC();
+  humidity = bme.getHumidity_cRH();
+  pressure = bme.getPressure_Pa_Q8() >> 8;
+#endif
+
+#ifdef USE_LSI_DRIFT_MODEL
+#ifdef USE_TIMER_SERVICE
+  // rtcCorrectionJob() picks it up
+  correction_temperature = temperature;
+#else
+  updateRTCCorrection(temperature);
+#endif
+#endif
+
+  // to uint16_t
+  uint16_t tempInt = temperature;
+  uint16_t humInt = humidity;
+  // pressure is already given in 100 x mBar = hPa
+  uint16_t pressInt = pressure / 10;
+
+#ifdef USE_ADAPTIVE_OVERSAMPLING
+  if (oversampling.update(temperature, pressure, humidity)) {
+    LOG_INFO("[BME280] Oversampling T/P/H: %u/%u/%u measurement: %lu us "
+             "%lu nC",
+             oversampling.getSampling(AdaptiveOversampling::CH_TEMPERATURE),
+             oversampling.getSampling(AdaptiveOversampling::CH_PRESSURE),
+             oversampling.getSampling(AdaptiveOversampling::CH_HUMIDITY),
+             oversampling.getMeasurementTime_us(), oversampling.getCharge_nC());
+  }
+#endif
+
+  LOG_INFO("Temperature: %u Humidity: %u Pressure: %u", tempInt, humInt,
+           pressInt);
+  LOG_DEBUG("MCU temperature: %ld", adc.temperature_cC);
+
+#ifndef USE_BME_STREAMING
+  // set forced mode to be shure it will use minimal power and send it to
+  // sleep bme.setForcedMode(); // moved in the setup
+  bme.goToSleep();
+#endif
+
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_PAYLOAD);
+#endif
+  PayloadWriter json(payload, sizeof(payload));
+  json.add("[{\"h\":").add((uint32_t)humInt);
+  json.add(",\"t\":").add((uint32_t)tempInt);
+  json.add(",\"p\":").add((uint32_t)pressInt);
+  json.add(",\"vcc\":").add(vcc);
+  json.add(",\"seq\":").add(packet_seq++).add("},");
+  json.add("{\"node\":\"").add(client_id).add("}]");
+
+  LOG_DEBUG("JSON PAYLOAD: %s", json.c_str());
+  if (json.overflow()) {
+    LOG_ERROR("[PAYLOAD] truncated, increase PAYLOAD_SIZE");
+  }
+
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_RADIO_TX);
+  energy.countCycle();
+#endif
+  digitalWrite(NSS_RADIO, LOW);
+  transmission_state = radio.startTransmit(json.c_str());
+  radio.sleep();
+  digitalWrite(NSS_RADIO, HIGH);
+}
+
+#ifdef USE_DIAGNOSTICS
+// charge per phase in uC since boot, mean current and projected battery
+// life, stack high-water mark, heap and untouched RAM in bytes, sent right
+// after every DIAG_INTERVAL-th packet
+void sendDiagnostics() {
+#ifdef USE_CLOCK_PROFILES
+  ClockScope clock(CLOCK_HSI16);
+#endif
+  PayloadWriter json(payload, sizeof(payload));
+  json.add("[{\"diag\":");
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_PAYLOAD);
+  uint32_t average_nA = energy.getAverageCurrent_nA();
+  uint32_t life_h = energy.getBatteryLife_h(BATTERY_CAPACITY_MAH);
+  LOG_INFO("[ENERGY] cycles %lu average nA %lu battery life h %lu",
+           energy.getCycles(), average_nA, life_h);
+
+  json.add(energy.getCycles());
+  for (uint8_t i = 0; i < EnergyMeter::PHASE_COUNT; i++) {
+    EnergyMeter::Phase phase = (EnergyMeter::Phase)i;
+    json.add(",\"").add(EnergyMeter::getName(phase)).add("\":");
+    json.add((uint32_t)(energy.getCharge_nC(phase) / 1000));
+  }
+  json.add(",\"nA\":").add(average_nA);
+  json.add(",\"life_h\":").add(life_h);
+#else
+  // no cycle count without the energy meter
+  json.add((uint32_t)0);
+#endif
+#ifdef USE_STACK_MONITOR
+  uint32_t stack = StackMonitor.getHighWater();
+  uint32_t heap = StackMonitor.getHeap();
+  uint32_t untouched = StackMonitor.getFree();
+  LOG_INFO("[RAM] static %lu heap %lu stack high-water %lu untouched %lu",
+           StackMonitor.getStaticRam(), heap, stack, untouched);
+
+  json.add(",\"stk\":").add(stack);
+  json.add(",\"heap\":").add(heap);
+  json.add(",\"free\":").add(untouched);
+#endif
+  json.add(",\"seq\":").add(packet_seq++).add("},");
+  json.add("{\"node\":\"").add(client_id).add("}]");
+  LOG_DEBUG("JSON PAYLOAD: %s", json.c_str());
+  if (json.overflow()) {
+    LOG_ERROR("[PAYLOAD] truncated, increase PAYLOAD_SIZE");
+  }
+
+#ifdef USE_ENERGY_METER
+  energy.start(EnergyMeter::PHASE_RADIO_TX);
+#endif
+  digitalWrite(NSS_RADIO, LOW);
+  transmission_state = radio.startTransmit(json.c_str());
+  radio.sleep();
+  digitalWrite(NSS_RADIO, HIGH);
+}
+
+// counts the finished packets, true when a diagnostics packet went out
+bool diagnosticsDue() {
+  if (--diag_countdown > 0) {
+    return false;
+  }
+  diag_countdown = DIAG_INTERVAL;
+  sendDiagnostics();
   return true;
 }
+#endif
+
+#ifdef USE_TIMER_SERVICE
+// periodic job on the timer service, sends a packet when a sample is ready
+void sampleJob(void *data) {
+  (void)data;
+#ifdef USE_BME_STREAMING
+  bmeStream.poll();
+  if (!bmeStream.ready()) {
+    return;
+  }
+#endif
+  sendPacket();
+}
+
+#ifdef USE_LOW_POWER_CAL
+// periodic job on the timer service, follows the LSI drift
+void rtcCorrectionJob(void *data) {
+  (void)data;
+#ifdef USE_CLOCK_PROFILES
+  // the TIM21 capture resolution follows the system clock
+  ClockScope clock(CLOCK_HSI16);
+#endif
+#ifdef USE_LSI_DRIFT_MODEL
+  if (correction_temperature != INT32_MIN) {
+    updateRTCCorrection(correction_temperature);
+  }
+#else
+  if (LowPowerCal.calibrateLSI()) {
+    LowPowerCal.applyRTCCalibration();
+    LOG_INFO("[RTC] LSI calibrated, correction ppm %ld",
+             LowPowerCal.getRTCTimeCorrection_ppm());
+  }
+#endif
+}
+#endif
+#endif
 
 void setup() {
+#ifdef USE_STACK_MONITOR
+  // before anything else runs on the stack
+  StackMonitor.paint();
+#endif
+
   /* Setup serial debug */
 #ifdef DEBUG_MAIN
   DEBUG_BEGIN(9600);
+  TokenLogger.begin(DEBUG_PORT);
+#endif
+#if defined(DEBUG_MAIN) && defined(USE_DMA_UART)
+  // a short sleep rather than lost log records
+  DebugUart.setSleepPolicy(DEBUG_UART_WAIT);
 #endif
 
   pinMode(NSS_RADIO, OUTPUT);
   digitalWrite(NSS_RADIO, HIGH);
 
+#ifdef USE_CONFIG_STORE
+  ConfigStore.begin();
+  sleep_interval = ConfigStore.getU32(CONFIG_SLEEP_INTERVAL, SLEEP_INTERVAL);
+  ConfigStore.getString(CONFIG_CLIENT_ID, client_id, sizeof(client_id),
+                        CLIENT_ID);
+#endif
+
+#if defined(USE_BOOT_CACHE) || \
+    (defined(USE_CONFIG_STORE) && defined(USE_SLEEP_GOVERNOR))
+  const uint32_t build_id =
+      STM32DataEEPROM::crc32(BUILD_STAMP, sizeof(BUILD_STAMP) - 1);
+#endif
+
+#ifdef USE_BOOT_CACHE
+  // after a reset other than power-on, a valid record written by this build
+  // skips the slow boot steps
+  bool warm_boot = BootCache.load(build_id);
+  if (warm_boot) {
+    LOG_INFO("[BOOT] warm");
+  } else {
+    LOG_INFO("[BOOT] cold");
+  }
+#else
+  bool warm_boot = false;
+#endif
+
+#ifdef USE_STANDBY
+  // after a standby wakeup the retained state replaces the slow boot steps
+  bool standby_wakeup = LowPower.resumedFromStandby() && Retention.load();
+  if (standby_wakeup) {
+    packet_seq = Retention.sequence;
+    LOG_INFO("[BOOT] standby");
+  }
+#else
+  bool standby_wakeup = false;
+#endif
+
   /* Time for serial settings */
-  delay(1000);
+  if (!warm_boot && !standby_wakeup) {
+    delay(1000);
+  }
 
 #ifdef USE_LOW_POWER_CAL
   /************************************************
    * get TimeCorrection number for RTC times
    ************************************************/
-  // wait 8 seconds to upload new code and
-  // calibrate the RTC times with the HSI internal clock
-  // time calibration on device with correct timing (ideal 8000.00)
-  // incease this time to shorten time between send and receive
-  LowPowerCal.setRTCCalibrationTime(calTimeDivider);
-  // callibrate for 8 seconds
-  LowPowerCal.calibrateRTC();
-  DEBUG_PRINT("RTC Time Correction: ");
-  DEBUG_PRINTLN(LowPowerCal.getRTCTimeCorrection(), 5);
+  if (standby_wakeup) {
+#ifdef USE_STANDBY
+    LowPowerCal.setRTCTimeCorrectionQ16(Retention.rtcCorrectionQ16);
+#endif
+  } else if (warm_boot) {
+#ifdef USE_BOOT_CACHE
+    LowPowerCal.setRTCTimeCorrectionQ16(BootCache.rtcCorrectionQ16);
+#endif
+  } else {
+    // calibrate the RTC times with the HSI internal clock
+    // time calibration on device with correct timing (ideal 8000.00)
+    // incease this time to shorten time between send and receive
+#ifdef USE_CONFIG_STORE
+    LowPowerCal.setRTCCalibrationTime(
+        ConfigStore.getU32(CONFIG_CAL_TIME_DIVIDER, calTimeDivider));
+#else
+    LowPowerCal.setRTCCalibrationTime(calTimeDivider);
+#endif
+    // measure the LSI with TIM21 in a few ms, the 8 seconds RTC comparison
+    // is the fallback
+    if (!LowPowerCal.calibrateLSI()) {
+      LowPowerCal.calibrateRTC();
+    }
+  }
+  LOG_INFO("RTC Time Correction ppm: %ld",
+           LowPowerCal.getRTCTimeCorrection_ppm());
+  // the RTC runs at the corrected rate, alarms and calendar need no scaling
+  if (LowPowerCal.applyRTCCalibration()) {
+    LOG_INFO("RTC residual ppb: %ld", LowPowerCal.getResidual_ppb());
+  }
+#endif
+
+#ifdef USE_TIMEBASE
+  // after the calibration, which sets the RTC time
+#ifdef USE_STANDBY
+  if (standby_wakeup) {
+    Timebase.begin(Retention.timebaseEpoch);
+  } else {
+    Timebase.begin();
+  }
+#else
+  Timebase.begin();
+#endif
 #endif
 
 /* Begin communication with BME280 and set to default sampling, iirc, and
  * standby settings */
+  LOG_INFO("[BME280] Initializing ... ");
+  if (!initializeBME280(warm_boot)) {
+    // Optional: Blink LED or show error
 #ifdef DEBUG_MAIN
-  DEBUG_PRINTLN("[BME280] Initializing ... ");
+    TokenLogger.flush();
 #endif
-  if (!initializeBME280()) {
-    // Optional: Blink LED or show error
     while (true)
       ; // Halt
   }
 
-  // initialize SX1278 with default settings
-#ifdef DEBUG_MAIN
-  DEBUG_PRINTLN("[RFM95/SX1276] Initializing ... ");
+#ifdef USE_BME_STREAMING
+  bmeStream.begin(BME280::STANDBY_1000_MS, BME280::IIRC_4);
+  LOG_INFO("[BME280] nC per sample forced: %lu normal: %lu",
+           BME280Stream::getForcedCharge_nC(bme, STREAM_INTERVAL,
+                                            MCU_RUN_CURRENT_UA),
+           BME280Stream::getNormalCharge_nC(bme, BME280::STANDBY_1000_MS,
+                                            STREAM_INTERVAL));
 #endif
+
+  // initialize SX1278 with default settings
+  LOG_INFO("[RFM95/SX1276] Initializing ... ");
   digitalWrite(NSS_RADIO, LOW); // Enable RFM95
-  int state =
-      radio.begin(915.0, 125.0, 9, 7, RADIOLIB_SX127X_SYNC_WORD, 17, 8, 0);
+  int state = radioBegin(radioConfig());
   if (state == RADIOLIB_ERR_NONE) {
-#ifdef DEBUG_MAIN
-    DEBUG_PRINTLN("[RFM95/SX1276] Initialized");
-#endif
+    LOG_INFO("[RFM95/SX1276] Initialized");
   } else {
-
+    LOG_ERROR("[RFM95/SX1276] failed, code %d", state);
 #ifdef DEBUG_MAIN
-    DEBUG_PRINT("[RFM95/SX1276] failed, code ");
-    DEBUG_PRINTLN(state);
+    TokenLogger.flush();
 #endif
     while (true) {
       delay(10);
@@ -148,102 +745,190 @@ void setup() {
   // when packet transmission is finished
   radio.setPacketSentAction(set_flag);
 
+#ifdef USE_BUS_TRACE
+  BusTracer.setBudget(BUS_BUDGET_TRANSACTIONS, BUS_BUDGET_BYTES);
+  // the begin() sequences are not part of a sample cycle
+  BusTracer.reset();
+#endif
+
   digitalWrite(NSS_RADIO, HIGH); // Disable RFM95
 
 // Configure low power
 #ifdef USE_LOW_POWER
   LowPower.begin();
 #endif
-}
-
-void loop() {
-
-  // check if the previous transmission finished
-  if (transmitted_flag) {
-
-    // reset flag
-    transmitted_flag = false;
 
-    if (transmission_state == RADIOLIB_ERR_NONE) {
-// packet was successfully sent
+#ifdef USE_POWER_HOOKS
+  // peripherals and pins that are not needed while sleeping
+  int8_t hook = PowerHooks.add("bus", busSuspend, busResume);
+  PowerHooks.addPin(hook, PA6); // MISO
+  PowerHooks.add("intref", intRefSuspend);
 #ifdef DEBUG_MAIN
-      DEBUG_PRINTLN("PACKET SUCCESSFULLY TRANSMITTED!");
+  hook = PowerHooks.add("serial", serialSuspend, nullptr, DEEP_SLEEP_MODE);
+  PowerHooks.addPin(hook, PA2);
+  PowerHooks.addPin(hook, PA3);
+#endif
 #endif
 
-      // NOTE: when using interrupt-driven transmit method,
-      //       it is not possible to automatically measure
-      //       transmission data rate using getDataRate()
-
-    } else {
-#ifdef DEBUG_MAIN
-      DEBUG_PRINT(F("failed, code "));
-      DEBUG_PRINTLN(transmission_state);
+#ifdef USE_SLEEP_GOVERNOR
+  // mode latencies are measured once per build and kept in the configuration
+  // store, they depend on the clock setup and the wakeup path of the build
+  SleepGovernor.setRunCurrent_uA(MCU_RUN_CURRENT_UA);
+#ifdef USE_CONFIG_STORE
+  if (ConfigStore.getU32(CONFIG_LATENCY_BUILD, 0) == build_id) {
+    SleepGovernor.setLatency_us(IDLE_MODE,
+                                ConfigStore.getU32(CONFIG_LATENCY_IDLE, 0));
+    SleepGovernor.setLatency_us(SLEEP_MODE,
+                                ConfigStore.getU32(CONFIG_LATENCY_SLEEP, 0));
+    SleepGovernor.setLatency_us(
+        DEEP_SLEEP_MODE, ConfigStore.getU32(CONFIG_LATENCY_DEEP_SLEEP, 0));
+  } else if (SleepGovernor.calibrate()) {
+    ConfigStore.setU32(CONFIG_LATENCY_IDLE,
+                       SleepGovernor.getLatency_us(IDLE_MODE));
+    ConfigStore.setU32(CONFIG_LATENCY_SLEEP,
+                       SleepGovernor.getLatency_us(SLEEP_MODE));
+    ConfigStore.setU32(CONFIG_LATENCY_DEEP_SLEEP,
+                       SleepGovernor.getLatency_us(DEEP_SLEEP_MODE));
+    // last, an interrupted update is measured again
+    ConfigStore.setU32(CONFIG_LATENCY_BUILD, build_id);
+  } else {
+    // measured again on the next boot
+    LOG_WARN("[SLEEP] latency calibration failed, not stored");
+  }
+#else
+  if (!SleepGovernor.calibrate()) {
+    LOG_WARN("[SLEEP] latency calibration failed");
+  }
+#endif
+  LOG_INFO("[SLEEP] latency idle/sleep/stop us: %lu/%lu/%lu",
+           SleepGovernor.getLatency_us(IDLE_MODE),
+           SleepGovernor.getLatency_us(SLEEP_MODE),
+           SleepGovernor.getLatency_us(DEEP_SLEEP_MODE));
 #endif
-    }
 
-    // clean up after transmission is finished
-    // this will ensure transmitter is disabled,
-    // RF switch is powered down etc.
-    radio.finishTransmit();
+#ifdef USE_RTC_PERIODIC_WAKEUP
+  // the wakeup timer reloads itself, the loop only enters stop mode and the
+  // packets follow the timer instead of the end of the transmission
+#ifdef USE_BME_STREAMING
+  LowPower.setPeriodicWakeup(STREAM_INTERVAL);
+#else
+  LowPower.setPeriodicWakeup(sleep_interval);
+#endif
+#endif
 
-    // wait before transmitting again
-#ifdef USE_LOW_POWER
-    LowPower.deepSleep(SLEEP_INTERVAL);
+#ifdef USE_BOOT_CACHE
+  if (!warm_boot) {
+    bme.getTrimming(&BootCache.trimming);
+#ifdef USE_LOW_POWER_CAL
+    BootCache.rtcCorrectionQ16 = LowPowerCal.getRTCTimeCorrectionQ16();
 #else
-    delay(SLEEP_INTERVAL);
+    BootCache.rtcCorrectionQ16 = 1UL << 16;
+#endif
+    BootCache.save(build_id);
+  }
 #endif
 
-    // send another one
-#ifdef DEBUG_MAIN
-    DEBUG_PRINTLN(F("[SX1278] Sending another packet ... "));
+#ifndef USE_BME_STREAMING
+  // after a warm reset the first packet goes out right away, a stream has
+  // no samples before its first decimation window
+  skip_sleep = warm_boot || standby_wakeup;
 #endif
 
-    // Prepare upstream data transmission at the next possible time.
-    // read vcc and add to bytebuffer
-    int32_t vcc = IntRef.readVref();
+#ifdef USE_TIMER_SERVICE
+  // the sample job runs on absolute deadlines, so the awake time does not
+  // stretch the interval
+#ifdef USE_BME_STREAMING
+  const uint32_t sample_period = STREAM_INTERVAL;
+#else
+  const uint32_t sample_period = sleep_interval;
+#endif
+  uint64_t now = Timebase.getMillis();
+  TimerService.start(now + (skip_sleep ? 0 : sample_period), sample_period,
+                     sampleJob);
+#ifdef USE_LOW_POWER_CAL
+  // from the same start, so every correction falls on a sample deadline
+  TimerService.start(now + RTC_CORRECTION_INTERVAL, RTC_CORRECTION_INTERVAL,
+                     rtcCorrectionJob);
+#endif
+#endif
 
-    // reading data from BME sensor
-    digitalWrite(NSS_RADIO, HIGH);
-    bme.readSensor();
-    float tempFloat = bme.getTemperature_C();
-    float humFloat = bme.getHumidity_RH();
-    float pressFloat = bme.getPressure_Pa();
+#ifdef USE_CLOCK_PROFILES
+  // calibration and begin() ran at 32 MHz, the wakeups run at 2 MHz and
+  // stop mode returns to the current profile without the PLL lock
+  ClockManager.onBeforeChange(clockChanging);
+  ClockManager.onChange(clockChanged);
+  ClockManager.setBase(CLOCK_MSI_2M);
+#endif
 
-    // from float to uint16_t
-    uint16_t tempInt = 100 * tempFloat;
-    uint16_t humInt = 100 * humFloat;
-    // pressure is already given in 100 x mBar = hPa
-    uint16_t pressInt = pressFloat / 10;
+#ifdef USE_HEAP_GUARD
+  // RadioLib and the core allocate during setup, the loop must not
+  HeapGuard.lock();
+#endif
 
-/* uncomment to debug */
-#ifdef DEBUG_MAIN
-    DEBUG_PRINT("Temperature: ");
-    DEBUG_PRINTLN(tempInt);
-    DEBUG_PRINT("Humidity: ");
-    DEBUG_PRINTLN(humInt);
-    DEBUG_PRINT("Pressure: ");
-    DEBUG_PRINTLN(pressInt);
+#ifdef USE_STACK_MONITOR
+  // setup() is usually the deepest, the loop figures follow in the
+  // diagnostics
+  LOG_INFO("[RAM] static %lu heap %lu stack high-water %lu untouched %lu",
+           StackMonitor.getStaticRam(), StackMonitor.getHeap(),
+           StackMonitor.getHighWater(), StackMonitor.getFree());
 #endif
+}
 
-    // set forced mode to be shure it will use minimal power and send it to
-    // sleep bme.setForcedMode(); // moved in the setup
-    bme.goToSleep();
+void loop() {
+#ifdef USE_TIMER_SERVICE
+  // the jobs start the transmissions, the loop finishes them and sleeps
+  // until the next deadline
+  if (transmitted_flag) {
+    transmitted_flag = false;
+    finishTransmission();
+#ifdef USE_DIAGNOSTICS
+    diagnosticsDue();
+#endif
+  }
+  TimerService.run();
+#ifdef DEBUG_MAIN
+  TokenLogger.flush();
+  DEBUG_PREPARE_SLEEP();
+#endif
+#ifdef USE_ENERGY_METER
+  // the MCU sleeps through the airtime of a packet just started, that time
+  // stays with the transmission
+  bool transmitting = (energy.getPhase() == EnergyMeter::PHASE_RADIO_TX) &&
+                      !transmitted_flag;
+  energy.suspend();
+  uint64_t sleep_start = Timebase.getMillis();
+  TimerService.sleep();
+  uint32_t slept = Timebase.elapsed_ms(sleep_start);
+  if (transmitting) {
+    energy.addTime_ms(EnergyMeter::PHASE_RADIO_TX, slept);
+    energy.start(EnergyMeter::PHASE_RADIO_TX);
+  } else {
+    energy.addSleep_ms(slept);
+    energy.start(EnergyMeter::PHASE_WAKE);
+  }
+#else
+  TimerService.sleep();
+#endif
+#else
+  // check if the previous transmission finished
+  if (transmitted_flag) {
 
-    String clientId = "NS001";
-    // String str = String(t) + "," + String(h) + "," + String(p) + "," +
-    // String(a);
-    String str = String("[{\"h\":") + humInt + ",\"t\":" + tempInt +
-                 ",\"p\":" + pressInt + ",\"vcc\":" + vcc + "},";
-    str += String("{\"node\":\"") + clientId + "}]";
+    // reset flag
+    transmitted_flag = false;
 
+    finishTransmission();
+#ifdef USE_DIAGNOSTICS
+    // the diagnostics packet is finished on the next pass, then it sleeps
+    if (diagnosticsDue()) {
+      return;
+    }
+#endif
 #ifdef DEBUG_MAIN
-    DEBUG_PRINT("JSON PAYLOAD: ");
-    DEBUG_PRINTLN(str);
+    // the records of the cycle go out in one burst before sleeping
+    TokenLogger.flush();
 #endif
-
-    digitalWrite(NSS_RADIO, LOW);
-    transmission_state = radio.startTransmit(str.c_str());
-    radio.sleep();
-    digitalWrite(NSS_RADIO, HIGH);
+    waitForNextSample();
+    sendPacket();
   }
+#endif
 }
\ No newline at end of file
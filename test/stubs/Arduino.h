@@ -0,0 +1,96 @@
+/*
+@file   Arduino.h
+@brief  Host stand-in for the Arduino core, just enough for the libraries
+        under test in [env:native]. Time only moves through delay() and
+        delayMicroseconds(), pin writes go to an optional hook.
+*/
+
+#ifndef _NATIVE_ARDUINO_H_
+#define _NATIVE_ARDUINO_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+
+#define DEC 10
+#define HEX 16
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// the core takes min() and max() from the standard library in C++
+using std::max;
+using std::min;
+
+// simulated time in us
+inline uint64_t nativeMicros = 0;
+// called on every digitalWrite(), for chip select tracking
+inline void (*nativePinHook)(uint8_t pin, uint8_t val) = nullptr;
+
+inline void pinMode(uint32_t pin, uint32_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+inline void digitalWrite(uint32_t pin, uint32_t val) {
+  if (nativePinHook != nullptr) {
+    nativePinHook((uint8_t)pin, (uint8_t)val);
+  }
+}
+
+inline void delay(uint32_t ms) { nativeMicros += (uint64_t)ms * 1000; }
+inline void delayMicroseconds(uint32_t us) { nativeMicros += us; }
+inline uint32_t millis() { return (uint32_t)(nativeMicros / 1000); }
+inline uint32_t micros() { return (uint32_t)nativeMicros; }
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t *buffer, size_t size) {
+    size_t n = 0;
+    while (size--) {
+      n += write(*buffer++);
+    }
+    return n;
+  }
+
+  size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned long n, int base = DEC) {
+    char buf[24];
+    snprintf(buf, sizeof(buf), (base == HEX) ? "%lX" : "%lu", n);
+    return print(buf);
+  }
+  size_t print(long n, int base = DEC) {
+    if ((base == DEC) && (n < 0)) {
+      return print('-') + print((unsigned long)-n);
+    }
+    return print((unsigned long)n, base);
+  }
+  size_t print(unsigned char n, int base = DEC) {
+    return print((unsigned long)n, base);
+  }
+  size_t print(int n, int base = DEC) { return print((long)n, base); }
+  size_t print(unsigned int n, int base = DEC) {
+    return print((unsigned long)n, base);
+  }
+
+  template <typename T> size_t println(T value) {
+    return print(value) + println();
+  }
+  template <typename T> size_t println(T value, int base) {
+    return print(value, base) + println();
+  }
+  size_t println() { return print("\r\n"); }
+};
+
+#endif // _NATIVE_ARDUINO_H_
@@ -0,0 +1,41 @@
+/*
+@file   SPI.h
+@brief  Host stand-in for the Arduino SPI library, every byte goes to the
+        simulated device on nativeSpiTransfer
+*/
+
+#ifndef _NATIVE_SPI_H_
+#define _NATIVE_SPI_H_
+
+#include "Arduino.h"
+
+#define MSBFIRST 1
+#define SPI_MODE0 0x00
+
+// full duplex byte exchange with the simulated device
+inline uint8_t (*nativeSpiTransfer)(uint8_t data) = nullptr;
+
+class SPISettings {
+public:
+  SPISettings() {}
+  SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) {
+    (void)clock;
+    (void)bitOrder;
+    (void)dataMode;
+  }
+};
+
+class SPIClass {
+public:
+  void begin() {}
+  void end() {}
+  void beginTransaction(SPISettings settings) { (void)settings; }
+  void endTransaction() {}
+  uint8_t transfer(uint8_t data) {
+    return (nativeSpiTransfer != nullptr) ? nativeSpiTransfer(data) : 0;
+  }
+};
+
+inline SPIClass SPI;
+
+#endif // _NATIVE_SPI_H_
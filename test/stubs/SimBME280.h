@@ -0,0 +1,132 @@
+/*
+@file   SimBME280.h
+@brief  Simulated BME280 on the host SPI stub. Register file with the
+        datasheet example trimming (section 8.1), a forced conversion shows
+        the measuring bit on one status read and clears it on the next.
+*/
+
+#ifndef _SIM_BME280_H_
+#define _SIM_BME280_H_
+
+#include "Arduino.h"
+#include "SPI.h"
+
+// raw counts of the datasheet example, 25.08 degC and 100653 Pa
+#define SIM_BME280_ADC_T 519888
+#define SIM_BME280_ADC_P 415148
+#define SIM_BME280_ADC_H 30000
+
+class SimBME280 {
+
+public:
+  explicit SimBME280(uint8_t csPin) : _csPin(csPin) {
+    memset(_regs, 0, sizeof(_regs));
+    static const uint8_t trimming[] = {
+        0x70, 0x6B, // T1 27504
+        0x43, 0x67, // T2 26435
+        0x18, 0xFC, // T3 -1000
+        0x7D, 0x8E, // P1 36477
+        0x43, 0xD6, // P2 -10685
+        0xD0, 0x0B, // P3 3024
+        0x27, 0x0B, // P4 2855
+        0x8C, 0x00, // P5 140
+        0xF9, 0xFF, // P6 -7
+        0x8C, 0x3C, // P7 15500
+        0xF8, 0xC6, // P8 -14600
+        0x70, 0x17, // P9 6000
+    };
+    memcpy(&_regs[0x88], trimming, sizeof(trimming));
+    _regs[0xA1] = 75;   // H1
+    _regs[0xE1] = 0x6A; // H2 362
+    _regs[0xE2] = 0x01;
+    _regs[0xE3] = 0;    // H3
+    _regs[0xE4] = 0x13; // H4 313 = 0x139
+    _regs[0xE5] = 0x29; // H4 [3:0], H5 [3:0]
+    _regs[0xE6] = 0x03; // H5 50 = 0x032
+    _regs[0xE7] = 30;   // H6
+    _regs[0xD0] = 0x60;
+    setCounts(SIM_BME280_ADC_T, SIM_BME280_ADC_P, SIM_BME280_ADC_H);
+  }
+
+  // route the SPI and pin stubs to this device
+  void attach() {
+    _active = this;
+    nativePinHook = pinHook;
+    nativeSpiTransfer = transferHook;
+  }
+
+  void setCounts(uint32_t adcT, uint32_t adcP, uint32_t adcH) {
+    _regs[0xF7] = (uint8_t)(adcP >> 12);
+    _regs[0xF8] = (uint8_t)(adcP >> 4);
+    _regs[0xF9] = (uint8_t)(adcP << 4);
+    _regs[0xFA] = (uint8_t)(adcT >> 12);
+    _regs[0xFB] = (uint8_t)(adcT >> 4);
+    _regs[0xFC] = (uint8_t)(adcT << 4);
+    _regs[0xFD] = (uint8_t)(adcH >> 8);
+    _regs[0xFE] = (uint8_t)adcH;
+  }
+
+  uint8_t getRegister(uint8_t reg) { return _regs[reg]; }
+  uint32_t getConversions() { return _conversions; }
+
+private:
+  static void pinHook(uint8_t pin, uint8_t val) {
+    if (pin == _active->_csPin) {
+      _active->_selected = (val == LOW);
+      _active->_first = true;
+    }
+  }
+
+  static uint8_t transferHook(uint8_t data) {
+    return _active->_selected ? _active->transfer(data) : 0xFF;
+  }
+
+  uint8_t transfer(uint8_t data) {
+    if (_first) {
+      // bit 7 set reads, cleared writes, the address auto increments
+      _first = false;
+      _read = (data & 0x80) != 0;
+      _addr = data | 0x80;
+      return 0xFF;
+    }
+    if (_read) {
+      return readRegister(_addr++);
+    }
+    writeRegister(_addr, data);
+    _first = true; // writes are address / data pairs
+    return 0xFF;
+  }
+
+  uint8_t readRegister(uint8_t reg) {
+    if (reg == 0xF3) {
+      uint8_t status = (_measuring > 0) ? 0x08 : 0x00;
+      if (_measuring > 0) {
+        _measuring--;
+      }
+      return status;
+    }
+    return _regs[reg];
+  }
+
+  void writeRegister(uint8_t reg, uint8_t data) {
+    _regs[reg] = data;
+    if ((reg == 0xF4) && ((data & 0x03) == 0x01 || (data & 0x03) == 0x02)) {
+      // forced mode: one conversion, ctrl_meas reads back as written
+      _measuring = 1;
+      _conversions++;
+    }
+  }
+
+  static inline SimBME280 *_active = nullptr;
+
+  uint8_t _regs[256];
+  uint8_t _csPin;
+  bool _selected = false;
+  bool _first = true;
+  bool _read = false;
+  uint8_t _addr = 0;
+  uint8_t _measuring = 0;
+  uint32_t _conversions = 0;
+};
+
+#endif // _SIM_BME280_H_
@@ -0,0 +1,34 @@
+/*
+@file   Wire.h
+@brief  Host stand-in for the Arduino Wire library, there is no I2C device
+*/
+
+#ifndef _NATIVE_WIRE_H_
+#define _NATIVE_WIRE_H_
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+  void begin() {}
+  void setClock(uint32_t clock) { (void)clock; }
+  void beginTransmission(uint8_t address) { (void)address; }
+  size_t write(uint8_t data) {
+    (void)data;
+    return 1;
+  }
+  uint8_t endTransmission(bool stop = true) {
+    (void)stop;
+    return 2; // NACK on the address
+  }
+  uint8_t requestFrom(uint8_t address, uint8_t count) {
+    (void)address;
+    (void)count;
+    return 0;
+  }
+  int read() { return -1; }
+};
+
+inline TwoWire Wire;
+
+#endif // _NATIVE_WIRE_H_
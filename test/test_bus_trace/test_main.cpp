@@ -0,0 +1,133 @@
+/*
+@file   test_main.cpp
+@brief  Bus traffic of one sample cycle against the budget in BusTrace.h.
+        The BME280 driver runs against the simulated sensor, the SX1276
+        part replays the sessions RadioLib issues for one transmission.
+*/
+
+#include <unity.h>
+
+#include "BME280.h"
+#include "BusTrace.h"
+#include "SimBME280.h"
+
+#define BME_CS 1
+#define RADIO_CS 4
+#define RADIO_SPI_CLOCK 2000000
+
+// longest payload of the transmit node, 15 character node name
+#define PAYLOAD_LENGTH 94
+
+struct RadioSession {
+  uint8_t reg;
+  BusTrace::Direction dir;
+  uint16_t bytes;
+};
+
+/*
+  SX1276 sessions of startTransmit(), sleep() and finishTransmit() in
+  RadioLib 7.2. SPIsetRegValue() reads, writes and reads back. Re-record
+  with USE_BUS_TRACE on the node when RadioLib is updated.
+*/
+static const RadioSession radioCycle[] = {
+    // startTransmit: standby, modem check, DIO0 on TX done, length
+    {0x01, BusTrace::BUS_READ, 1},
+    {0x01, BusTrace::BUS_WRITE, 1},
+    {0x01, BusTrace::BUS_READ, 1},
+    {0x01, BusTrace::BUS_READ, 1},
+    {0x40, BusTrace::BUS_READ, 1},
+    {0x40, BusTrace::BUS_WRITE, 1},
+    {0x40, BusTrace::BUS_READ, 1},
+    {0x22, BusTrace::BUS_READ, 1},
+    {0x22, BusTrace::BUS_WRITE, 1},
+    {0x22, BusTrace::BUS_READ, 1},
+    // clear the IRQ flags, FIFO pointers, payload, TX mode
+    {0x12, BusTrace::BUS_WRITE, 1},
+    {0x0E, BusTrace::BUS_WRITE, 1},
+    {0x0D, BusTrace::BUS_WRITE, 1},
+    {0x00, BusTrace::BUS_WRITE, PAYLOAD_LENGTH},
+    {0x01, BusTrace::BUS_READ, 1},
+    {0x01, BusTrace::BUS_WRITE, 1},
+    {0x01, BusTrace::BUS_READ, 1},
+    // sleep
+    {0x01, BusTrace::BUS_READ, 1},
+    {0x01, BusTrace::BUS_WRITE, 1},
+    {0x01, BusTrace::BUS_READ, 1},
+    // finishTransmit: clear the IRQ flags, standby
+    {0x12, BusTrace::BUS_WRITE, 1},
+    {0x01, BusTrace::BUS_READ, 1},
+    {0x01, BusTrace::BUS_WRITE, 1},
+    {0x01, BusTrace::BUS_READ, 1},
+};
+
+static SimBME280 sim(BME_CS);
+static BME280 bme(SPI, BME_CS);
+
+// the BME280 part of sendPacket() without streaming
+static void sensorCycle() {
+  TEST_ASSERT_EQUAL(1, bme.readSensor());
+  bme.goToSleep();
+}
+
+static void radioReplay() {
+  for (size_t i = 0; i < sizeof(radioCycle) / sizeof(radioCycle[0]); i++) {
+    BusTracer.record(RADIO_CS, radioCycle[i].reg, radioCycle[i].dir,
+                     radioCycle[i].bytes, RADIO_SPI_CLOCK);
+  }
+}
+
+void setUp(void) {
+  sim.attach();
+  // as initializeBME280() does on a cold boot
+  bme.setForcedMode();
+  TEST_ASSERT_EQUAL(1, bme.begin());
+  BusTracer.setBudget(BUS_BUDGET_TRANSACTIONS, BUS_BUDGET_BYTES);
+  BusTracer.reset();
+}
+
+void tearDown(void) {}
+
+void test_sample_cycle_within_budget(void) {
+  sensorCycle();
+  radioReplay();
+
+  char report[96];
+  snprintf(report, sizeof(report),
+           "transactions %u/%u bytes %u/%u bus time %u us",
+           (unsigned)BusTracer.getTransactions(), BUS_BUDGET_TRANSACTIONS,
+           (unsigned)BusTracer.getBytes(), BUS_BUDGET_BYTES,
+           (unsigned)BusTracer.getDuration_us());
+  TEST_MESSAGE(report);
+  TEST_ASSERT_FALSE_MESSAGE(BusTracer.overBudget(), report);
+}
+
+void test_sensor_cycle_sessions(void) {
+  uint32_t conversions = sim.getConversions();
+  sensorCycle();
+
+  // ctrl_meas, two status polls, the data burst, sleep and its read back
+  TEST_ASSERT_EQUAL(6, BusTracer.getTransactions());
+  TEST_ASSERT_EQUAL(conversions + 1, sim.getConversions());
+  const BusTrace::Entry *burst = BusTracer.getEntry(3);
+  TEST_ASSERT_TRUE(burst != NULL);
+  TEST_ASSERT_EQUAL(0xF7, burst->reg);
+  TEST_ASSERT_EQUAL(8, burst->bytes);
+}
+
+void test_extra_session_breaks_budget(void) {
+  sensorCycle();
+  radioReplay();
+  // one more status poll of the radio
+  BusTracer.record(RADIO_CS, 0x12, BusTrace::BUS_READ, 1, RADIO_SPI_CLOCK);
+  TEST_ASSERT_TRUE(BusTracer.overBudget());
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_sample_cycle_within_budget);
+  RUN_TEST(test_sensor_cycle_sessions);
+  RUN_TEST(test_extra_session_breaks_budget);
+  return UNITY_END();
+}
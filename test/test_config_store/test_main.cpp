@@ -0,0 +1,208 @@
+/*
+@file   test_main.cpp
+@brief  Configuration store on the image file backend of STM32DataEEPROM:
+        typed values, the log wrapping over superseded records, the index
+        rebuilt on reload, a record torn by a reset and string keys.
+*/
+
+#include <unity.h>
+
+#include <stdio.h>
+
+#include "STM32ConfigStore.h"
+
+#define IMAGE_FILE "test_config_store.bin"
+
+// offset of the check in a record, the last halfword programmed
+#define SLOT_CHECK 14
+
+enum : uint8_t {
+  KEY_INTERVAL = 1,
+  KEY_OFFSET = 2,
+  KEY_CLIENT = 3,
+  KEY_SPARE = 31
+};
+
+// a new instance reads the log back like a reset does
+static uint32_t reloadU32(uint8_t key, uint32_t def) {
+  STM32ConfigStore store;
+  store.begin();
+  return store.getU32(key, def);
+}
+
+static uint32_t slotOffset(uint8_t slot) {
+  return CONFIG_STORE_OFFSET + slot * CONFIG_STORE_SLOT_SIZE;
+}
+
+void setUp(void) {
+  remove(IMAGE_FILE);
+  DataEEPROM.setFile(IMAGE_FILE);
+  ConfigStore.begin();
+}
+
+void tearDown(void) { remove(IMAGE_FILE); }
+
+void test_erased_store_reads_defaults(void) {
+  TEST_ASSERT_FALSE(ConfigStore.has(KEY_INTERVAL));
+  TEST_ASSERT_EQUAL_UINT32(60000, ConfigStore.getU32(KEY_INTERVAL, 60000));
+  TEST_ASSERT_EQUAL_INT32(-7, ConfigStore.getI32(KEY_OFFSET, -7));
+  TEST_ASSERT_EQUAL_UINT32(0, ConfigStore.getSequence());
+}
+
+void test_typed_set_get_and_overwrite(void) {
+  TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, 300000));
+  TEST_ASSERT_TRUE(ConfigStore.setI32(KEY_OFFSET, -1250));
+  TEST_ASSERT_TRUE(ConfigStore.has(KEY_INTERVAL));
+  TEST_ASSERT_EQUAL_UINT32(300000, ConfigStore.getU32(KEY_INTERVAL, 0));
+  TEST_ASSERT_EQUAL_INT32(-1250, ConfigStore.getI32(KEY_OFFSET, 0));
+
+  TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, 120000));
+  TEST_ASSERT_EQUAL_UINT32(120000, ConfigStore.getU32(KEY_INTERVAL, 0));
+  TEST_ASSERT_EQUAL_UINT32(3, ConfigStore.getSequence());
+
+  // an unchanged value is not written again
+  TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, 120000));
+  TEST_ASSERT_EQUAL_UINT32(3, ConfigStore.getSequence());
+
+  TEST_ASSERT_EQUAL_UINT32(120000, reloadU32(KEY_INTERVAL, 0));
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)-1250, reloadU32(KEY_OFFSET, 0));
+}
+
+void test_rejects_invalid_keys_and_sizes(void) {
+  uint8_t value[CONFIG_STORE_VALUE_SIZE + 1] = {0};
+
+  TEST_ASSERT_FALSE(ConfigStore.setU32(0, 1));
+  TEST_ASSERT_FALSE(ConfigStore.setU32(CONFIG_STORE_MAX_KEYS, 1));
+  TEST_ASSERT_FALSE(ConfigStore.set(KEY_SPARE, value, sizeof(value)));
+  TEST_ASSERT_TRUE(ConfigStore.set(KEY_SPARE, value, 2));
+  // a value of another size reads as missing
+  TEST_ASSERT_EQUAL_UINT32(5, ConfigStore.getU32(KEY_SPARE, 5));
+  TEST_ASSERT_EQUAL_UINT32(1, ConfigStore.getSequence());
+}
+
+/*
+  Three times around the log with one key changing on every write. The keys
+  written once before are never overwritten, the reload finds the newest
+  record of each key and continues the sequence.
+*/
+void test_log_wraps_and_rebuilds_index(void) {
+  const uint32_t writes = 3 * CONFIG_STORE_SLOTS;
+
+  TEST_ASSERT_TRUE(ConfigStore.setI32(KEY_OFFSET, -42));
+  TEST_ASSERT_TRUE(ConfigStore.setString(KEY_CLIENT, "node-07"));
+  for (uint32_t i = 1; i <= writes; i++) {
+    TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, i));
+  }
+  TEST_ASSERT_EQUAL_UINT32(writes + 2, ConfigStore.getSequence());
+
+  STM32ConfigStore store;
+  char client[16];
+  store.begin();
+  TEST_ASSERT_EQUAL_UINT32(writes, store.getU32(KEY_INTERVAL, 0));
+  TEST_ASSERT_EQUAL_INT32(-42, store.getI32(KEY_OFFSET, 0));
+  TEST_ASSERT_TRUE(store.getString(KEY_CLIENT, client, sizeof(client), ""));
+  TEST_ASSERT_EQUAL_STRING("node-07", client);
+  TEST_ASSERT_EQUAL_UINT32(writes + 2, store.getSequence());
+
+  // the reloaded head writes over the oldest superseded record
+  TEST_ASSERT_TRUE(store.setU32(KEY_INTERVAL, 7));
+  TEST_ASSERT_EQUAL_UINT32(7, reloadU32(KEY_INTERVAL, 0));
+  TEST_ASSERT_EQUAL_UINT32((uint32_t)-42, reloadU32(KEY_OFFSET, 0));
+}
+
+/*
+  A reset while a record is programmed leaves the check unwritten, the
+  record fails it and the previous value of the key stays valid.
+*/
+void test_torn_write_keeps_previous_value(void) {
+  const uint16_t erased = 0;
+
+  TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, 1000));
+  TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, 2000));
+  // the second record went into slot 1 of the empty log
+  TEST_ASSERT_TRUE(
+      DataEEPROM.write(slotOffset(1) + SLOT_CHECK, &erased, sizeof(erased)));
+
+  STM32ConfigStore store;
+  store.begin();
+  TEST_ASSERT_EQUAL_UINT32(1000, store.getU32(KEY_INTERVAL, 0));
+  TEST_ASSERT_EQUAL_UINT32(1, store.getSequence());
+
+  // the torn slot is reused and the store goes on
+  TEST_ASSERT_TRUE(store.setU32(KEY_INTERVAL, 3000));
+  TEST_ASSERT_EQUAL_UINT32(3000, reloadU32(KEY_INTERVAL, 0));
+}
+
+// a torn value byte fails the check just as well
+void test_corrupted_value_is_ignored(void) {
+  uint8_t byte;
+
+  TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, 1000));
+  DataEEPROM.read(slotOffset(0) + 6, &byte, 1);
+  byte ^= 0x10;
+  TEST_ASSERT_TRUE(DataEEPROM.write(slotOffset(0) + 6, &byte, 1));
+
+  STM32ConfigStore store;
+  store.begin();
+  TEST_ASSERT_FALSE(store.has(KEY_INTERVAL));
+  TEST_ASSERT_EQUAL_UINT32(99, store.getU32(KEY_INTERVAL, 99));
+}
+
+void test_string_keys(void) {
+  char buf[16];
+
+  TEST_ASSERT_FALSE(ConfigStore.getString(KEY_CLIENT, buf, sizeof(buf), "def"));
+  TEST_ASSERT_EQUAL_STRING("def", buf);
+
+  TEST_ASSERT_TRUE(ConfigStore.setString(KEY_CLIENT, "node-01"));
+  TEST_ASSERT_TRUE(ConfigStore.getString(KEY_CLIENT, buf, sizeof(buf), "def"));
+  TEST_ASSERT_EQUAL_STRING("node-01", buf);
+
+  // the full value size fits, the terminator is not stored
+  TEST_ASSERT_TRUE(ConfigStore.setString(KEY_CLIENT, "12345678"));
+  TEST_ASSERT_TRUE(ConfigStore.getString(KEY_CLIENT, buf, sizeof(buf), "def"));
+  TEST_ASSERT_EQUAL_STRING("12345678", buf);
+
+  // a short buffer truncates
+  char small[5];
+  TEST_ASSERT_TRUE(
+      ConfigStore.getString(KEY_CLIENT, small, sizeof(small), "def"));
+  TEST_ASSERT_EQUAL_STRING("1234", small);
+
+  // too long or empty strings are refused, the stored one stays
+  TEST_ASSERT_FALSE(ConfigStore.setString(KEY_CLIENT, "123456789"));
+  TEST_ASSERT_FALSE(ConfigStore.setString(KEY_CLIENT, ""));
+
+  STM32ConfigStore store;
+  store.begin();
+  TEST_ASSERT_TRUE(store.getString(KEY_CLIENT, buf, sizeof(buf), "def"));
+  TEST_ASSERT_EQUAL_STRING("12345678", buf);
+}
+
+void test_format_erases_all_keys(void) {
+  TEST_ASSERT_TRUE(ConfigStore.setU32(KEY_INTERVAL, 1));
+  TEST_ASSERT_TRUE(ConfigStore.setString(KEY_CLIENT, "x"));
+  ConfigStore.format();
+  TEST_ASSERT_FALSE(ConfigStore.has(KEY_INTERVAL));
+  TEST_ASSERT_EQUAL_UINT32(0, reloadU32(KEY_INTERVAL, 0));
+
+  STM32ConfigStore store;
+  store.begin();
+  TEST_ASSERT_FALSE(store.has(KEY_CLIENT));
+  TEST_ASSERT_EQUAL_UINT32(0, store.getSequence());
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_erased_store_reads_defaults);
+  RUN_TEST(test_typed_set_get_and_overwrite);
+  RUN_TEST(test_rejects_invalid_keys_and_sizes);
+  RUN_TEST(test_log_wraps_and_rebuilds_index);
+  RUN_TEST(test_torn_write_keeps_previous_value);
+  RUN_TEST(test_corrupted_value_is_ignored);
+  RUN_TEST(test_string_keys);
+  RUN_TEST(test_format_erases_all_keys);
+  return UNITY_END();
+}
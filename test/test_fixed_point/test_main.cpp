@@ -0,0 +1,168 @@
+/*
+@file   test_main.cpp
+@brief  Fixed point BME280 results and RTC correction against the float
+        code they replaced and the floating point compensation of the
+        datasheet (section 8.1). The host has an FPU, so the cycles saved
+        on the Cortex-M0+ are not measured here.
+*/
+
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include "BME280.h"
+#include "SimBME280.h"
+
+#define BME_CS 1
+
+// trimming of SimBME280
+#define DIG_T1 27504.0
+#define DIG_T2 26435.0
+#define DIG_T3 -1000.0
+#define DIG_P1 36477.0
+#define DIG_P2 -10685.0
+#define DIG_P3 3024.0
+#define DIG_P4 2855.0
+#define DIG_P5 140.0
+#define DIG_P6 -7.0
+#define DIG_P7 15500.0
+#define DIG_P8 -14600.0
+#define DIG_P9 6000.0
+#define DIG_H1 75.0
+#define DIG_H2 362.0
+#define DIG_H3 0.0
+#define DIG_H4 313.0
+#define DIG_H5 50.0
+#define DIG_H6 30.0
+
+static SimBME280 sim(BME_CS);
+static BME280 bme(SPI, BME_CS);
+
+struct Reference {
+  double temperature_C;
+  double pressure_Pa;
+  double humidity_RH;
+};
+
+// floating point compensation of the datasheet
+static Reference compensate(int32_t adcT, int32_t adcP, int32_t adcH) {
+  Reference r;
+  double var1 = (adcT / 16384.0 - DIG_T1 / 1024.0) * DIG_T2;
+  double var2 = (adcT / 131072.0 - DIG_T1 / 8192.0) *
+                (adcT / 131072.0 - DIG_T1 / 8192.0) * DIG_T3;
+  double t_fine = var1 + var2;
+  r.temperature_C = t_fine / 5120.0;
+
+  var1 = t_fine / 2.0 - 64000.0;
+  var2 = var1 * var1 * DIG_P6 / 32768.0;
+  var2 = var2 + var1 * DIG_P5 * 2.0;
+  var2 = var2 / 4.0 + DIG_P4 * 65536.0;
+  var1 = (DIG_P3 * var1 * var1 / 524288.0 + DIG_P2 * var1) / 524288.0;
+  var1 = (1.0 + var1 / 32768.0) * DIG_P1;
+  double p = 1048576.0 - adcP;
+  p = (p - var2 / 4096.0) * 6250.0 / var1;
+  var1 = DIG_P9 * p * p / 2147483648.0;
+  var2 = p * DIG_P8 / 32768.0;
+  r.pressure_Pa = p + (var1 + var2 + DIG_P7) / 16.0;
+
+  double h = t_fine - 76800.0;
+  h = (adcH - (DIG_H4 * 64.0 + DIG_H5 / 16384.0 * h)) *
+      (DIG_H2 / 65536.0 *
+       (1.0 + DIG_H6 / 67108864.0 * h * (1.0 + DIG_H3 / 67108864.0 * h)));
+  h = h * (1.0 - DIG_H1 * h / 524288.0);
+  r.humidity_RH = (h > 100.0) ? 100.0 : ((h < 0.0) ? 0.0 : h);
+  return r;
+}
+
+static void sample(int32_t adcT, int32_t adcP, int32_t adcH) {
+  sim.setCounts(adcT, adcP, adcH);
+  TEST_ASSERT_EQUAL(1, bme.readSensor());
+}
+
+// deepSleep() before and after the change
+static int floatSleep(uint32_t ms, float factor) {
+  return (int)roundf((float)ms * factor);
+}
+
+static int fixedSleep(uint32_t ms, uint32_t q16) {
+  return (int)(((uint64_t)ms * q16 + 0x8000) >> 16);
+}
+
+void setUp(void) {
+  sim.attach();
+  bme.setForcedMode();
+  TEST_ASSERT_EQUAL(1, bme.begin());
+}
+
+void tearDown(void) {}
+
+/*
+  -40 to 85 degC, 300 to 1100 hPa and the humidity range. The payload
+  values match the float code within its rounding: it truncated
+  100 * (T / 100.0f), which could lose 0.01 degC, and the 24-bit mantissa
+  rounds the pressure above 65536 Pa to 1/128 Pa.
+*/
+void test_payload_matches_float_and_datasheet(void) {
+  for (int32_t adcT = 400000; adcT <= 640000; adcT += 4000) {
+    for (int32_t adcP = 250000; adcP <= 500000; adcP += 25000) {
+      for (int32_t adcH = 20000; adcH <= 50000; adcH += 10000) {
+        sample(adcT, adcP, adcH);
+        Reference ref = compensate(adcT, adcP, adcH);
+
+        char message[64];
+        snprintf(message, sizeof(message), "adc T %d P %d H %d", (int)adcT,
+                 (int)adcP, (int)adcH);
+        int32_t temperature = bme.getTemperature_cC();
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(
+            1, (int32_t)(100 * bme.getTemperature_C()), temperature, message);
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(1, lround(ref.temperature_C * 100),
+                                         temperature, message);
+
+        int32_t pressure = bme.getPressure_Pa_Q8() >> 8;
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(1, (int32_t)bme.getPressure_Pa(),
+                                         pressure, message);
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(2, lround(ref.pressure_Pa), pressure,
+                                         message);
+
+        int32_t humidity = bme.getHumidity_cRH();
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(
+            1, (int32_t)(100 * bme.getHumidity_RH()), humidity, message);
+        TEST_ASSERT_INT32_WITHIN_MESSAGE(5, lround(ref.humidity_RH * 100),
+                                         humidity, message);
+      }
+    }
+  }
+}
+
+// the datasheet example, 25.08 degC
+void test_datasheet_example(void) {
+  sample(SIM_BME280_ADC_T, SIM_BME280_ADC_P, SIM_BME280_ADC_H);
+  TEST_ASSERT_EQUAL(2508, bme.getTemperature_cC());
+}
+
+/*
+  Sleep times up to the 10 minute correction interval with factors of the
+  LSI range. The factor is stored in 16.16 either way, the float code only
+  did the scaling in float.
+*/
+void test_rtc_correction_matches_float(void) {
+  static const uint32_t ms[] = {1, 999, 10000, 60000, 300000, 600000};
+  for (uint32_t q16 = 45000; q16 <= 100000; q16 += 997) {
+    float factor = (float)q16 / 65536.0f;
+    for (uint8_t i = 0; i < sizeof(ms) / sizeof(ms[0]); i++) {
+      TEST_ASSERT_INT32_WITHIN(1, floatSleep(ms[i], factor),
+                               fixedSleep(ms[i], q16));
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_payload_matches_float_and_datasheet);
+  RUN_TEST(test_datasheet_example);
+  RUN_TEST(test_rtc_correction_matches_float);
+  return UNITY_END();
+}
@@ -0,0 +1,151 @@
+/*
+@file   test_main.cpp
+@brief  LSI measurement of calibrateLSI() against simulated TIM21 capture
+        sequences: the 16-bit counter wraps between and at the captures,
+        the timer runs at twice PCLK2 when APB2 is divided.
+*/
+
+#include <stdio.h>
+#include <unity.h>
+
+#include "LsiCapture.h"
+
+// LSI frequency the RTC prescalers assume
+#define LSI_NOMINAL 37000
+
+// calibrateLSI() default, 32 intervals of 8 LSI periods
+#define PERIODS 256
+
+#define PLL_32M 32000000
+#define HSI_16M 16000000
+#define MSI_2M 2097152
+
+/*
+  Captures of TIM21 running at timer_hz from counter_start, one every
+  LSI_CAL_IC_DIV rising edges of an LSI at lsi_hz. The first edge comes a
+  third of a timer clock after the start, the counter value is the timer
+  clocks elapsed at the edge.
+*/
+static LsiCapture simulateTim21(uint32_t timer_hz, uint32_t lsi_hz,
+                                uint16_t counter_start, uint32_t *elapsed) {
+  LsiCapture capture;
+  uint64_t first = 0;
+  for (uint32_t i = 0; i <= PERIODS / LSI_CAL_IC_DIV; i++) {
+    uint64_t at = ((uint64_t)i * LSI_CAL_IC_DIV * timer_hz + lsi_hz / 3) /
+                  lsi_hz;
+    if (i == 0) {
+      first = at;
+    }
+    *elapsed = (uint32_t)(at - first);
+    capture.add((uint16_t)(counter_start + at));
+  }
+  return capture;
+}
+
+// nearest 16.16 value of lsi_hz / LSI_NOMINAL
+static uint32_t exactQ16(uint32_t lsi_hz) {
+  return (uint32_t)(((uint64_t)lsi_hz * 65536 + LSI_NOMINAL / 2) /
+                    LSI_NOMINAL);
+}
+
+// one timer clock of quantization over the whole measurement, plus rounding
+static uint32_t toleranceQ16(uint32_t expected, uint32_t ticks) {
+  return expected / ticks + 1;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_ticks_across_counter_wraps(void) {
+  uint32_t elapsed = 0;
+  LsiCapture capture = simulateTim21(PLL_32M, LSI_NOMINAL, 0xFF00, &elapsed);
+
+  // 221405 timer clocks, the counter wraps three times
+  TEST_ASSERT_GREATER_THAN(3 * 65536, elapsed);
+  TEST_ASSERT_EQUAL(PERIODS / LSI_CAL_IC_DIV, capture.intervals);
+  TEST_ASSERT_EQUAL(elapsed, capture.ticks);
+}
+
+void test_wrap_at_the_first_capture(void) {
+  uint32_t elapsed = 0;
+  LsiCapture capture = simulateTim21(MSI_2M, LSI_NOMINAL, 0xFFFF, &elapsed);
+
+  TEST_ASSERT_EQUAL(elapsed, capture.ticks);
+}
+
+void test_nominal_lsi_is_unity(void) {
+  uint32_t elapsed = 0;
+  LsiCapture capture = simulateTim21(PLL_32M, LSI_NOMINAL, 0x1234, &elapsed);
+  uint32_t q16 = lsiCorrectionQ16(capture.intervals * LSI_CAL_IC_DIV,
+                                  capture.ticks, PLL_32M, LSI_NOMINAL);
+
+  TEST_ASSERT_UINT32_WITHIN(1, 65536, q16);
+}
+
+// the LSI of the STM32L0 is 26 to 56 kHz (DS10152, table 42)
+void test_lsi_range_on_each_profile(void) {
+  static const uint32_t lsi[] = {26000, 32000, 37000, 42000, 56000};
+  static const uint32_t timer[] = {MSI_2M, HSI_16M, PLL_32M};
+
+  for (uint8_t t = 0; t < sizeof(timer) / sizeof(timer[0]); t++) {
+    for (uint8_t l = 0; l < sizeof(lsi) / sizeof(lsi[0]); l++) {
+      uint32_t elapsed = 0;
+      LsiCapture capture = simulateTim21(timer[t], lsi[l], 0xF000, &elapsed);
+      uint32_t q16 = lsiCorrectionQ16(capture.intervals * LSI_CAL_IC_DIV,
+                                      capture.ticks, timer[t], LSI_NOMINAL);
+      uint32_t expected = exactQ16(lsi[l]);
+
+      char message[48];
+      snprintf(message, sizeof(message), "timer %u Hz LSI %u Hz",
+               (unsigned)timer[t], (unsigned)lsi[l]);
+      TEST_ASSERT_UINT32_WITHIN_MESSAGE(toleranceQ16(expected, capture.ticks),
+                                        expected, q16, message);
+    }
+  }
+}
+
+/*
+  MSI 2 MHz with APB2 divided by 2: PCLK2 is 1 MHz, TIM21 counts at 2 MHz.
+  Taking PCLK2 as the timer clock would halve the correction.
+*/
+void test_apb2_divided_timer_clock(void) {
+  uint32_t pclk2 = MSI_2M / 2;
+  uint32_t timer_hz = lsiTimerClock(pclk2, true);
+  TEST_ASSERT_EQUAL(MSI_2M, timer_hz);
+  TEST_ASSERT_EQUAL(pclk2, lsiTimerClock(pclk2, false));
+
+  uint32_t elapsed = 0;
+  LsiCapture capture = simulateTim21(timer_hz, 39000, 0xFFF0, &elapsed);
+  uint32_t periods = capture.intervals * LSI_CAL_IC_DIV;
+  uint32_t expected = exactQ16(39000);
+
+  TEST_ASSERT_UINT32_WITHIN(
+      toleranceQ16(expected, capture.ticks), expected,
+      lsiCorrectionQ16(periods, capture.ticks, timer_hz, LSI_NOMINAL));
+  TEST_ASSERT_UINT32_WITHIN(
+      toleranceQ16(expected, capture.ticks), expected / 2,
+      lsiCorrectionQ16(periods, capture.ticks, pclk2, LSI_NOMINAL));
+}
+
+void test_no_capture_keeps_unity(void) {
+  LsiCapture capture;
+  capture.add(0x4321);
+
+  TEST_ASSERT_EQUAL(0, capture.intervals);
+  TEST_ASSERT_EQUAL(65536,
+                    lsiCorrectionQ16(0, capture.ticks, PLL_32M, LSI_NOMINAL));
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_ticks_across_counter_wraps);
+  RUN_TEST(test_wrap_at_the_first_capture);
+  RUN_TEST(test_nominal_lsi_is_unity);
+  RUN_TEST(test_lsi_range_on_each_profile);
+  RUN_TEST(test_apb2_divided_timer_clock);
+  RUN_TEST(test_no_capture_keeps_unity);
+  return UNITY_END();
+}
@@ -0,0 +1,128 @@
+/*
+@file   test_main.cpp
+@brief  Temperature model of the LSI correction against a simulated LSI
+        drifting linearly with temperature: calibrations needed, fitted
+        slope and prediction error, the mean-only model below 1 degC of
+        spread and the calibration due after 360 predictions.
+*/
+
+#include <unity.h>
+
+#include <math.h>
+
+#include "LsiDriftModel.h"
+
+// linear LSI drift of the simulation, ppm per degC around 20 degC
+#define DRIFT_PPM 150
+#define DRIFT_CENTER 2000
+
+// samples of the swing, one per sendPacket()
+#define SAMPLES 2000
+// 20 +- 15 degC, one period every 600 samples
+#define SWING_AMPLITUDE 1500
+#define SWING_PERIOD 600
+
+static LsiDriftModel model;
+
+// temperature in 0.01 degC of sample i
+static int32_t swing(int i) {
+  return DRIFT_CENTER +
+         (int32_t)lround(SWING_AMPLITUDE * sin(2 * M_PI * i / SWING_PERIOD));
+}
+
+// 16.16 correction of the simulated LSI at a temperature in 0.01 degC
+static uint32_t lsiCorrection(int32_t temperature) {
+  return (uint32_t)lround(
+      65536.0 * (1.0 + DRIFT_PPM * 1e-6 * (temperature - DRIFT_CENTER) / 100));
+}
+
+void setUp(void) { model.reset(); }
+
+void tearDown(void) {}
+
+void test_empty_model_asks_for_calibration(void) {
+  TEST_ASSERT_TRUE(model.needsCalibration(DRIFT_CENTER));
+  TEST_ASSERT_EQUAL_UINT32(65536, model.predict(DRIFT_CENTER));
+  TEST_ASSERT_EQUAL_INT32(0, model.getSlope_ppm());
+}
+
+/*
+  Three periods of a 30 degC swing. The model calibrates 53 times instead
+  of 2000, the first ones while it has seen too little spread for a slope.
+  Once the slope is fitted the predictions stay within 2 LSB (31 ppm) of
+  the simulated LSI.
+*/
+void test_tracks_linear_drift(void) {
+  uint16_t calibrations = 0;
+  uint32_t worstFitted = 0;
+
+  for (int i = 0; i < SAMPLES; i++) {
+    int32_t temperature = swing(i);
+    uint32_t truth = lsiCorrection(temperature);
+    if (model.needsCalibration(temperature)) {
+      model.add(temperature, truth);
+      calibrations++;
+      continue;
+    }
+    uint32_t predicted = model.predict(temperature);
+    uint32_t error =
+        (predicted > truth) ? predicted - truth : truth - predicted;
+    if ((model.getSlope_ppm() != 0) && (error > worstFitted)) {
+      worstFitted = error;
+    }
+  }
+
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(60, calibrations);
+  TEST_ASSERT_GREATER_OR_EQUAL(SAMPLES / LSI_DRIFT_MAX_PREDICTIONS,
+                               calibrations);
+  TEST_ASSERT_INT32_WITHIN(2, DRIFT_PPM, model.getSlope_ppm());
+  TEST_ASSERT_LESS_OR_EQUAL_UINT32(2, worstFitted);
+  TEST_ASSERT_EQUAL(LSI_DRIFT_POINTS, model.getCount());
+}
+
+// points within 1 degC fit no slope, the model is their mean correction
+void test_small_spread_is_mean_only(void) {
+  model.add(2000, 65536);
+  model.add(2040, 65546);
+  model.add(2090, 65556);
+
+  TEST_ASSERT_EQUAL_INT32(0, model.getSlope_ppm());
+  TEST_ASSERT_EQUAL_UINT32(65546, model.predict(1500));
+  TEST_ASSERT_EQUAL_UINT32(65546, model.predict(2500));
+
+  // a calibration is due more than 2 degC from the nearest point
+  TEST_ASSERT_FALSE(model.needsCalibration(2090 + LSI_DRIFT_TEMP_STEP));
+  TEST_ASSERT_TRUE(model.needsCalibration(2090 + LSI_DRIFT_TEMP_STEP + 1));
+  TEST_ASSERT_TRUE(model.needsCalibration(2000 - LSI_DRIFT_TEMP_STEP - 1));
+
+  // 1 degC of spread is enough for a slope
+  model.add(2100, lsiCorrection(2100));
+  TEST_ASSERT_NOT_EQUAL(0, model.getSlope_ppm());
+}
+
+// a constant temperature still calibrates every 360 predictions
+void test_recalibrates_after_max_predictions(void) {
+  model.add(DRIFT_CENTER, 65536);
+
+  for (uint16_t i = 0; i < LSI_DRIFT_MAX_PREDICTIONS; i++) {
+    TEST_ASSERT_FALSE(model.needsCalibration(DRIFT_CENTER));
+    model.predict(DRIFT_CENTER);
+  }
+  TEST_ASSERT_TRUE(model.needsCalibration(DRIFT_CENTER));
+
+  // a new calibration starts the count again
+  model.add(DRIFT_CENTER, 65540);
+  TEST_ASSERT_FALSE(model.needsCalibration(DRIFT_CENTER));
+  TEST_ASSERT_EQUAL_UINT32(65538, model.predict(DRIFT_CENTER));
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_empty_model_asks_for_calibration);
+  RUN_TEST(test_tracks_linear_drift);
+  RUN_TEST(test_small_spread_is_mean_only);
+  RUN_TEST(test_recalibrates_after_max_predictions);
+  return UNITY_END();
+}
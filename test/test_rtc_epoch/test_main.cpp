@@ -0,0 +1,125 @@
+/*
+@file   test_main.cpp
+@brief  Integer calendar conversion of STM32RTC against the C library for
+        every day of the RTC range 2000 to 2099, and a host benchmark of
+        both. The timings are host ns, only the ratio carries over.
+*/
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdlib.h>
+#include <time.h>
+
+#include "rtc_calc.h"
+
+#define EPOCH_TIME_OFF 946684800 // 1st January 2000
+#define SECONDS_PER_DAY 86400
+// 1st January 2000 to 31st December 2099
+#define RTC_DAYS 36525
+
+static volatile uint32_t sink;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_civil_from_days_matches_gmtime(void) {
+  for (uint32_t days = 0; days < RTC_DAYS; days++) {
+    time_t t = (time_t)EPOCH_TIME_OFF + (time_t)days * SECONDS_PER_DAY;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+
+    uint8_t year, month, day, wday;
+    RTC_CivilFromDays(days, &year, &month, &day, &wday);
+    TEST_ASSERT_EQUAL(tm.tm_year - 100, year);
+    TEST_ASSERT_EQUAL(tm.tm_mon + 1, month);
+    TEST_ASSERT_EQUAL(tm.tm_mday, day);
+    // RTC weekdays run from Monday 1 to Sunday 7
+    TEST_ASSERT_EQUAL((tm.tm_wday == 0) ? 7 : tm.tm_wday, wday);
+  }
+}
+
+void test_days_from_civil_matches_gmtime(void) {
+  for (uint32_t days = 0; days < RTC_DAYS; days++) {
+    time_t t = (time_t)EPOCH_TIME_OFF + (time_t)days * SECONDS_PER_DAY;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    TEST_ASSERT_EQUAL(days, RTC_DaysFromCivil(tm.tm_year - 100, tm.tm_mon + 1,
+                                              tm.tm_mday));
+  }
+}
+
+void test_range_ends(void) {
+  uint8_t year, month, day, wday;
+  RTC_CivilFromDays(0, &year, &month, &day, &wday);
+  TEST_ASSERT_EQUAL(0, year);
+  TEST_ASSERT_EQUAL(1, month);
+  TEST_ASSERT_EQUAL(1, day);
+  TEST_ASSERT_EQUAL(6, wday); // Saturday
+  RTC_CivilFromDays(RTC_DAYS - 1, &year, &month, &day, &wday);
+  TEST_ASSERT_EQUAL(99, year);
+  TEST_ASSERT_EQUAL(12, month);
+  TEST_ASSERT_EQUAL(31, day);
+  TEST_ASSERT_EQUAL(4, wday); // Thursday
+  TEST_ASSERT_EQUAL(RTC_DAYS - 1, RTC_DaysFromCivil(99, 12, 31));
+}
+
+template <typename F> static double nsPerDay(F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t days = 0; days < RTC_DAYS; days++) {
+    f(days);
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() /
+         RTC_DAYS;
+}
+
+// reported only, host timings are too noisy to fail a test on
+void test_benchmark(void) {
+  // mktime works in local time, the RTC keeps UTC
+  setenv("TZ", "UTC", 1);
+  tzset();
+
+  double civil = nsPerDay([](uint32_t days) {
+    uint8_t year, month, day, wday;
+    RTC_CivilFromDays(days, &year, &month, &day, &wday);
+    sink = year + month + day + wday;
+  });
+  double gm = nsPerDay([](uint32_t days) {
+    time_t t = (time_t)EPOCH_TIME_OFF + (time_t)days * SECONDS_PER_DAY;
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    sink = tm.tm_year + tm.tm_mon + tm.tm_mday + tm.tm_wday;
+  });
+  double days = nsPerDay([](uint32_t d) {
+    sink = RTC_DaysFromCivil((uint8_t)(d / 366), (uint8_t)(d % 12 + 1),
+                             (uint8_t)(d % 28 + 1));
+  });
+  double mk = nsPerDay([](uint32_t d) {
+    struct tm tm = {};
+    tm.tm_year = 100 + d / 366;
+    tm.tm_mon = d % 12;
+    tm.tm_mday = d % 28 + 1;
+    tm.tm_isdst = -1;
+    sink = (uint32_t)mktime(&tm);
+  });
+
+  char line[96];
+  snprintf(line, sizeof(line), "ns per call civilFromDays %.1f gmtime %.1f",
+           civil, gm);
+  TEST_MESSAGE(line);
+  snprintf(line, sizeof(line), "ns per call daysFromCivil %.1f mktime %.1f",
+           days, mk);
+  TEST_MESSAGE(line);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_civil_from_days_matches_gmtime);
+  RUN_TEST(test_days_from_civil_matches_gmtime);
+  RUN_TEST(test_range_ends);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
@@ -0,0 +1,136 @@
+/*
+@file   test_main.cpp
+@brief  Periodic RTC wakeup against a simulated RTC. The wakeup timer
+        programming comes from RTC_WakeUpTimerTicks(), the simulation runs
+        both the periodic timer and the per sleep alarm of deepSleep(ms)
+        over many duty cycles.
+*/
+
+#include <unity.h>
+
+#include "rtc_calc.h"
+
+// LSI prescalers of STM32RTC for the nominal 37 kHz
+#define PREDIV_A 127
+#define PREDIV_S 288
+#define RTCCLK ((PREDIV_A + 1) * (PREDIV_S + 1))
+
+/*
+  RTC clocked from RTCCLK, time in ns. The calendar subseconds count at
+  RTCCLK / (PREDIV_A + 1), the wakeup timer at RTCCLK / 16 or ck_spre.
+*/
+class SimRtc {
+
+public:
+  explicit SimRtc(uint32_t rtcclk) : _rtcclk(rtcclk) {}
+
+  // periodic mode: wakeup k after start
+  uint64_t periodicWake_ns(uint32_t ms, uint32_t k) {
+    wakeUpClock_t clock;
+    uint32_t ticks;
+    if (!RTC_WakeUpTimerTicks(ms, RTCCLK, &clock, &ticks)) {
+      return 0;
+    }
+    uint64_t tick_ns_num = (clock == WAKEUP_CLOCK_CK_SPRE)
+                               ? (uint64_t)RTCCLK * 1000000000ULL
+                               : 16ULL * 1000000000ULL;
+    return (uint64_t)k * ticks * tick_ns_num / _rtcclk;
+  }
+
+  // alarm mode: the alarm is set ms after the end of the awake time, in
+  // subseconds of the calendar
+  uint64_t alarmWake_ns(uint64_t now_ns, uint32_t ms) {
+    uint64_t subsecond = (uint64_t)(PREDIV_A + 1) * 1000000000ULL;
+    uint64_t now = now_ns * _rtcclk / subsecond;
+    uint64_t alarm = now + (uint64_t)ms * (PREDIV_S + 1) / 1000;
+    return (alarm * subsecond + _rtcclk - 1) / _rtcclk;
+  }
+
+private:
+  uint32_t _rtcclk;
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_ticks_div16(void) {
+  wakeUpClock_t clock;
+  uint32_t ticks;
+  TEST_ASSERT_TRUE(RTC_WakeUpTimerTicks(1000, RTCCLK, &clock, &ticks));
+  TEST_ASSERT_EQUAL(WAKEUP_CLOCK_RTCCLK_DIV16, clock);
+  TEST_ASSERT_EQUAL(RTCCLK / 16, ticks);
+  TEST_ASSERT_TRUE(RTC_WakeUpTimerTicks(1, RTCCLK, &clock, &ticks));
+  TEST_ASSERT_EQUAL(2, ticks);
+}
+
+// RTCCLK/16 ends at 65536 ticks, 28.35 s, then whole seconds of ck_spre
+void test_ticks_ck_spre(void) {
+  wakeUpClock_t clock;
+  uint32_t ticks;
+  TEST_ASSERT_TRUE(RTC_WakeUpTimerTicks(28000, RTCCLK, &clock, &ticks));
+  TEST_ASSERT_EQUAL(WAKEUP_CLOCK_RTCCLK_DIV16, clock);
+  TEST_ASSERT_TRUE(RTC_WakeUpTimerTicks(29000, RTCCLK, &clock, &ticks));
+  TEST_ASSERT_EQUAL(WAKEUP_CLOCK_CK_SPRE, clock);
+  TEST_ASSERT_EQUAL(29, ticks);
+  TEST_ASSERT_TRUE(RTC_WakeUpTimerTicks(60400, RTCCLK, &clock, &ticks));
+  TEST_ASSERT_EQUAL(60, ticks);
+  TEST_ASSERT_TRUE(RTC_WakeUpTimerTicks(65536000, RTCCLK, &clock, &ticks));
+  TEST_ASSERT_EQUAL(65536, ticks);
+}
+
+void test_ticks_out_of_range(void) {
+  wakeUpClock_t clock;
+  uint32_t ticks;
+  TEST_ASSERT_FALSE(RTC_WakeUpTimerTicks(0, RTCCLK, &clock, &ticks));
+  TEST_ASSERT_FALSE(RTC_WakeUpTimerTicks(65537000, RTCCLK, &clock, &ticks));
+}
+
+// the periodic timer keeps the cadence however long the node is awake, the
+// alarm of deepSleep(ms) adds the awake time to every period
+void test_cadence_over_a_day(void) {
+  SimRtc rtc(RTCCLK);
+  const uint32_t period_ms = 60000;
+  const uint64_t awake_ns = 150000000ULL; // sample and transmit
+  const uint32_t cycles = 1440;
+
+  uint64_t periodic = rtc.periodicWake_ns(period_ms, cycles);
+  uint64_t alarm = 0;
+  for (uint32_t k = 0; k < cycles; k++) {
+    alarm = rtc.alarmWake_ns(alarm + awake_ns, period_ms);
+  }
+
+  uint64_t ideal = (uint64_t)cycles * period_ms * 1000000ULL;
+  TEST_ASSERT_EQUAL_INT64(ideal, periodic);
+  char line[80];
+  snprintf(line, sizeof(line), "after %u cycles alarm mode is %llu ms late",
+           (unsigned)cycles, (unsigned long long)((alarm - ideal) / 1000000));
+  TEST_MESSAGE(line);
+  // the alarm starts from the last whole subsecond, 3.46 ms
+  uint64_t subsecond_ns = (PREDIV_A + 1) * 1000000000ULL / RTCCLK;
+  TEST_ASSERT_GREATER_OR_EQUAL(cycles * (awake_ns - subsecond_ns),
+                               alarm - ideal);
+}
+
+// RTCCLK/16 periods are a whole number of ticks, the error stays below one
+// tick of 0.43 ms per period
+void test_div16_period_error(void) {
+  SimRtc rtc(RTCCLK);
+  const uint32_t periods_ms[] = {250, 1000, 5000, 10000, 28000};
+  for (size_t i = 0; i < sizeof(periods_ms) / sizeof(periods_ms[0]); i++) {
+    uint64_t wake = rtc.periodicWake_ns(periods_ms[i], 1);
+    int64_t error = (int64_t)wake - (int64_t)periods_ms[i] * 1000000;
+    TEST_ASSERT_INT_WITHIN(16ULL * 1000000000ULL / RTCCLK / 2 + 1, 0, error);
+  }
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_ticks_div16);
+  RUN_TEST(test_ticks_ck_spre);
+  RUN_TEST(test_ticks_out_of_range);
+  RUN_TEST(test_cadence_over_a_day);
+  RUN_TEST(test_div16_period_error);
+  return UNITY_END();
+}
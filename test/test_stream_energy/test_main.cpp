@@ -0,0 +1,101 @@
+/*
+@file   test_main.cpp
+@brief  Energy per output sample of forced and normal mode over the sample
+        period, from the BME280Stream model with the simulated sensor. The
+        table shows where each deployment is cheaper.
+*/
+
+#include <unity.h>
+
+#include "BME280.h"
+#include "BME280Stream.h"
+#include "BusTrace.h"
+#include "SimBME280.h"
+
+#define BME_CS 1
+
+// MCU run current at 32 MHz, as MCU_RUN_CURRENT_UA in main.h
+#define MCU_RUN_CURRENT_UA 6400
+
+static SimBME280 sim(BME_CS);
+static BME280 bme(SPI, BME_CS);
+static BME280Stream bmeStream(bme);
+
+static const uint32_t periods_ms[] = {1000,  2000,  5000,   10000,
+                                      20000, 60000, 300000};
+
+void setUp(void) {
+  sim.attach();
+  bme.setForcedMode();
+  TEST_ASSERT_EQUAL(1, bme.begin());
+}
+
+void tearDown(void) {}
+
+void test_energy_table(void) {
+  char line[96];
+  TEST_MESSAGE("period ms  forced nC  normal nC");
+  for (size_t i = 0; i < sizeof(periods_ms) / sizeof(periods_ms[0]); i++) {
+    uint32_t forced = BME280Stream::getForcedCharge_nC(bme, periods_ms[i],
+                                                       MCU_RUN_CURRENT_UA);
+    uint32_t normal = BME280Stream::getNormalCharge_nC(
+        bme, BME280::STANDBY_1000_MS, periods_ms[i]);
+    snprintf(line, sizeof(line), "%9u  %9u  %9u", (unsigned)periods_ms[i],
+             (unsigned)forced, (unsigned)normal);
+    TEST_MESSAGE(line);
+  }
+}
+
+// the lab nodes sample every second, there normal mode must win
+void test_normal_cheaper_at_one_second(void) {
+  TEST_ASSERT_LESS_THAN(
+      BME280Stream::getForcedCharge_nC(bme, 1000, MCU_RUN_CURRENT_UA),
+      BME280Stream::getNormalCharge_nC(bme, BME280::STANDBY_1000_MS, 1000));
+}
+
+// the default node sends every minute, there forced mode must win
+void test_forced_cheaper_at_one_minute(void) {
+  TEST_ASSERT_LESS_THAN(
+      BME280Stream::getNormalCharge_nC(bme, BME280::STANDBY_1000_MS, 60000),
+      BME280Stream::getForcedCharge_nC(bme, 60000, MCU_RUN_CURRENT_UA));
+}
+
+// forced mode pays the MCU run time of every conversion
+void test_forced_charge_parts(void) {
+  uint32_t t_meas = bme.getMeasurementTime_us();
+  uint32_t mcu_nC = t_meas * MCU_RUN_CURRENT_UA / 1000;
+  uint32_t forced =
+      BME280Stream::getForcedCharge_nC(bme, 1000, MCU_RUN_CURRENT_UA);
+  TEST_ASSERT_GREATER_OR_EQUAL(mcu_nC + bme.getMeasurementCharge_nC(), forced);
+}
+
+// a normal mode poll reads the data burst only, no conversion is started
+void test_normal_poll_reads_burst_only(void) {
+  TEST_ASSERT_EQUAL(1, bmeStream.begin(BME280::STANDBY_1000_MS,
+                                       BME280::IIRC_4, 2));
+  uint32_t conversions = sim.getConversions();
+  BusTracer.reset();
+  TEST_ASSERT_EQUAL(1, bmeStream.poll());
+  TEST_ASSERT_EQUAL(1, BusTracer.getTransactions());
+  TEST_ASSERT_EQUAL(0xF7, BusTracer.getEntry(0)->reg);
+  TEST_ASSERT_EQUAL(conversions, sim.getConversions());
+  TEST_ASSERT_EQUAL(1, bmeStream.poll());
+  TEST_ASSERT_TRUE(bmeStream.ready());
+
+  // datasheet example counts, 25.08 degC
+  int32_t temperature, pressure, humidity;
+  bmeStream.getMean(&temperature, &pressure, &humidity);
+  TEST_ASSERT_EQUAL(2508, temperature);
+}
+
+int main(int argc, char **argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_energy_table);
+  RUN_TEST(test_normal_cheaper_at_one_second);
+  RUN_TEST(test_forced_cheaper_at_one_minute);
+  RUN_TEST(test_forced_charge_parts);
+  RUN_TEST(test_normal_poll_reads_burst_only);
+  return UNITY_END();
+}